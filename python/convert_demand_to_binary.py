@@ -0,0 +1,57 @@
+import csv
+import datetime
+import struct
+import sys
+import time
+
+
+# The layouts of the binary demand file, matching the structs in src/simulator/demand_generator.hpp.
+FILE_HEADER = struct.Struct("<8sIIQ16s")
+RECORD = struct.Struct("<III")
+MAGIC = b"AMoD2DMD"
+
+
+def main():
+    """Convert a taxi data csv file (onid, dnid, ptime) to the binary demand file sorted by request time.
+    The request times are stored in seconds from the 0 clock of the base date, which is the date of the earliest
+    request unless given."""
+
+    stime = time.time()
+
+    if len(sys.argv) not in (3, 4):
+        print("[ERROR] Wrong arguments! \n"
+              "- Usage: python3 {} <path to csv> <path to output bin> [base date, e.g. 2016-05-25] \n"
+              "- Example: python3 {} ./datalog-gitignore/taxi-data/manhattan-taxi-20160525.csv "
+              "./datalog-gitignore/taxi-data/manhattan-taxi-20160525.bin \n".format(sys.argv[0], sys.argv[0]))
+        sys.exit(1)
+
+    path_to_csv = sys.argv[1]
+    path_to_bin = sys.argv[2]
+
+    requests = []
+    with open(path_to_csv) as file:
+        for row in csv.DictReader(file):
+            request_time = datetime.datetime.strptime(row["ptime"], "%Y-%m-%d %H:%M:%S")
+            requests.append((request_time, int(row["onid"]), int(row["dnid"])))
+    requests.sort(key=lambda request: request[0])
+    assert len(requests) > 0, "No request in {}!".format(path_to_csv)
+
+    if len(sys.argv) == 4:
+        base_date = datetime.datetime.strptime(sys.argv[3], "%Y-%m-%d")
+    else:
+        base_date = datetime.datetime(requests[0][0].year, requests[0][0].month, requests[0][0].day)
+    assert requests[0][0] >= base_date, "The base date must be no later than the earliest request!"
+
+    with open(path_to_bin, "wb") as file:
+        file.write(FILE_HEADER.pack(MAGIC, 1, RECORD.size, len(requests),
+                                    base_date.strftime("%Y-%m-%d").encode()))
+        for request_time, origin_node_id, destination_node_id in requests:
+            request_time_s = int((request_time - base_date).total_seconds())
+            file.write(RECORD.pack(origin_node_id, destination_node_id, request_time_s))
+
+    print("[INFO] ({}s) Converted {} requests from {} to {} (base date {}).".format(
+        round(time.time() - stime, 2), len(requests), path_to_csv, path_to_bin, base_date.strftime("%Y-%m-%d")))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,177 @@
+import gzip
+import io
+import struct
+import sys
+
+import yaml
+
+
+# The layouts of the binary datalog records, matching the structs in src/simulator/datalog.hpp.
+FILE_HEADER = struct.Struct("<8sII")
+FRAME_HEADER = struct.Struct("<QIIIIII")
+POINT = struct.Struct("<ff")
+VEHICLE_RECORD = struct.Struct("<IffIII")
+ORDER_RECORD = struct.Struct("<IIffffiiii")
+MAGIC = b"AMoD2LOG"
+SCHEDULE_UNCHANGED = 0xFFFFFFFF
+
+ORDER_STATUS = ["PENDING", "PICKING", "ONBOARD", "COMPLETE", "WALKAWAY"]
+
+# The magic bytes of the compressed datalogs.
+GZIP_MAGIC = b"\x1f\x8b"
+ZSTD_MAGIC = b"\x28\xb5\x2f\xfd"
+
+
+def open_datalog(path_to_datalog):
+    """Open the datalog as a binary file, decompressing it on the fly if it is compressed (gzip or zstd)."""
+
+    with open(path_to_datalog, "rb") as file:
+        magic = file.read(4)
+    if magic.startswith(GZIP_MAGIC):
+        return gzip.open(path_to_datalog, "rb")
+    if magic == ZSTD_MAGIC:
+        try:
+            import zstandard
+        except ImportError:
+            print("[ERROR] Reading a zstd compressed datalog requires the zstandard package (pip install zstandard).")
+            sys.exit(1)
+        return io.BufferedReader(zstandard.ZstdDecompressor().stream_reader(open(path_to_datalog, "rb"), closefd=True))
+    return open(path_to_datalog, "rb")
+
+
+def is_binary_datalog(path_to_datalog):
+    """Check whether the datalog is in binary format by its magic bytes."""
+
+    with open_datalog(path_to_datalog) as file:
+        return file.read(len(MAGIC)) == MAGIC
+
+
+def read_exactly(file, size):
+    """Read size bytes from file, or return None at the end of file."""
+
+    data = file.read(size)
+    if len(data) < size:
+        return None
+    return data
+
+
+def read_binary_frames(path_to_datalog):
+    """Read the binary datalog frame by frame. Each frame is a dict in the same layout as a yaml datalog frame.
+    The delta frames (and the keyframes, which leave out the archived orders) are applied to the state kept from the
+    previous frames, so that every frame is complete."""
+
+    with open_datalog(path_to_datalog) as file:
+        magic, version, _ = FILE_HEADER.unpack(file.read(FILE_HEADER.size))
+        assert magic == MAGIC, "{} is not a binary datalog!".format(path_to_datalog)
+        assert version == 2, "Unsupported binary datalog version {}!".format(version)
+
+        # The state of each vehicle: [lon, lat, step_idx, the full routes of the waypoints in its schedule].
+        vehicles = []
+        orders = {}
+
+        while True:
+            data = read_exactly(file, FRAME_HEADER.size)
+            if data is None:
+                return
+            system_time_ms, is_keyframe, num_vehicles, num_waypoints, num_points, num_orders, _ = \
+                FRAME_HEADER.unpack(data)
+
+            vehicle_records = list(VEHICLE_RECORD.iter_unpack(file.read(num_vehicles * VEHICLE_RECORD.size)))
+            waypoint_sizes = struct.unpack("<{}I".format(num_waypoints), file.read(num_waypoints * 4))
+            points = list(POINT.iter_unpack(file.read(num_points * POINT.size)))
+            order_records = ORDER_RECORD.iter_unpack(file.read(num_orders * ORDER_RECORD.size))
+
+            # Update the vehicles.
+            waypoint_idx = 0
+            point_idx = 0
+            for id, lon, lat, step_idx, num_waypoints_reached, num_vehicle_waypoints in vehicle_records:
+                while len(vehicles) <= id:
+                    vehicles.append([0.0, 0.0, 0, []])
+                vehicle = vehicles[id]
+                vehicle[0], vehicle[1], vehicle[2] = lon, lat, step_idx
+                if num_vehicle_waypoints == SCHEDULE_UNCHANGED:
+                    del vehicle[3][:num_waypoints_reached]
+                    continue
+                vehicle[3] = []
+                for _ in range(num_vehicle_waypoints):
+                    size = waypoint_sizes[waypoint_idx]
+                    vehicle[3].append(points[point_idx:point_idx + size])
+                    point_idx += size
+                    waypoint_idx += 1
+
+            # Update the orders.
+            for (id, status, origin_lon, origin_lat, destination_lon, destination_lat, request_time_ms,
+                 max_pickup_time_ms, pickup_time_ms, dropoff_time_ms) in order_records:
+                orders[id] = {"id": id,
+                              "origin": {"lon": origin_lon, "lat": origin_lat},
+                              "destination": {"lon": destination_lon, "lat": destination_lat},
+                              "status": ORDER_STATUS[status],
+                              "request_time_ms": request_time_ms,
+                              "max_pickup_time_ms": max_pickup_time_ms,
+                              "pickup_time_ms": pickup_time_ms,
+                              "dropoff_time_ms": dropoff_time_ms}
+
+            # Build the complete frame, where the route of the first waypoint starts from the vehicle's position.
+            frame = {"system_time_ms": system_time_ms, "vehicles": []}
+            for lon, lat, step_idx, routes in vehicles:
+                waypoints = []
+                for i, route in enumerate(routes):
+                    if i == 0:
+                        route = [(lon, lat)] + route[step_idx * 2 + 1:] if step_idx * 2 < len(route) else []
+                    waypoints.append([{"lon": p[0], "lat": p[1]} for p in route])
+                frame["vehicles"].append({"pos": {"lon": lon, "lat": lat},
+                                          "waypoints": waypoints if waypoints else None})
+            if orders:
+                frame["orders"] = list(orders.values())
+
+            yield frame
+
+
+def read_yaml_frames(path_to_datalog):
+    """Read the yaml datalog frame by frame, where the frames are separated by "---".
+    A frame leaves out the archived orders, which are kept from the previous frames, so that every frame is complete."""
+
+    orders = {}
+    with io.TextIOWrapper(open_datalog(path_to_datalog)) as file:
+        string = ""
+        for line in file:
+            if line == "---\n":
+                frame = yaml.safe_load(string)
+                for order in frame.get("orders") or []:
+                    orders[order["id"]] = order
+                if orders:
+                    frame["orders"] = list(orders.values())
+                yield frame
+                string = ""
+            else:
+                string += line
+
+
+def read_frames(path_to_datalog):
+    """Read the datalog frame by frame, in either format, compressed or not."""
+
+    if is_binary_datalog(path_to_datalog):
+        return read_binary_frames(path_to_datalog)
+    return read_yaml_frames(path_to_datalog)
+
+
+def main():
+    """Convert a binary (or compressed) datalog to the uncompressed yaml format."""
+
+    if len(sys.argv) != 3:
+        print("[ERROR] Wrong arguments! \n"
+              "- Usage: python3 {} <path to datalog> <path to output yaml datalog> \n".format(sys.argv[0]))
+        sys.exit(1)
+
+    num_frames = 0
+    with open(sys.argv[2], "w") as file:
+        for frame in read_frames(sys.argv[1]):
+            yaml.safe_dump(frame, file, default_flow_style=None, sort_keys=False)
+            file.write("---\n")
+            num_frames += 1
+
+    print("[INFO] Converted {} frames from {} to {}.".format(num_frames, sys.argv[1], sys.argv[2]))
+
+
+if __name__ == "__main__":
+    main()
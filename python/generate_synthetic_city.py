@@ -0,0 +1,144 @@
+import datetime
+import heapq
+import math
+import os
+import random
+import sys
+import time
+
+
+# The default size of the city, the spacing of the grid in degrees and the range of the road speeds in m/s.
+GRID_WIDTH = 10
+GRID_HEIGHT = 10
+LON_MIN = -74.0000
+LAT_MIN = 40.7000
+LON_STEP = 0.0040
+LAT_STEP = 0.0030
+MIN_SPEED_MPS = 5.0
+MAX_SPEED_MPS = 12.0
+METERS_PER_DEGREE_LAT = 111195.0
+
+# The demand: requests per hour between the start and end hours of the day.
+DATE = "2016-05-25"
+DEMAND_START_HOUR = 7
+DEMAND_END_HOUR = 11
+REQUESTS_PER_HOUR = 600
+
+
+def build_grid_city(width, height, rng):
+    """Build a grid city, where each node is linked to its 4 neighbours by roads (in both directions) of a random
+    speed. Returns the node positions (lon, lat) and the roads as {u: [(v, time_s, distance_m)]}, 0-indexed."""
+
+    nodes = []
+    for y in range(height):
+        for x in range(width):
+            nodes.append((LON_MIN + x * LON_STEP, LAT_MIN + y * LAT_STEP))
+
+    meters_per_degree_lon = METERS_PER_DEGREE_LAT * math.cos(math.radians(LAT_MIN))
+    roads = {u: [] for u in range(len(nodes))}
+    for y in range(height):
+        for x in range(width):
+            u = y * width + x
+            for v in ([u + 1] if x + 1 < width else []) + ([u + width] if y + 1 < height else []):
+                distance_m = round(math.hypot((nodes[v][0] - nodes[u][0]) * meters_per_degree_lon,
+                                              (nodes[v][1] - nodes[u][1]) * METERS_PER_DEGREE_LAT))
+                for a, b in ((u, v), (v, u)):
+                    time_s = max(1, round(distance_m / rng.uniform(MIN_SPEED_MPS, MAX_SPEED_MPS)))
+                    roads[a].append((b, time_s, distance_m))
+    return nodes, roads
+
+
+def compute_shortest_paths(nodes, roads):
+    """Compute the fastest path between all node pairs (Dijkstra from each node). Returns the travel time table, the
+    travel distance table (along the fastest path) and the predecessor table, in the layout read by the router."""
+
+    num_nodes = len(nodes)
+    time_table, distance_table, path_table = [], [], []
+    for origin in range(num_nodes):
+        times = [math.inf] * num_nodes
+        distances = [0] * num_nodes
+        predecessors = [-1] * num_nodes
+        times[origin] = 0
+        heap = [(0, origin)]
+        while heap:
+            time_s, u = heapq.heappop(heap)
+            if time_s > times[u]:
+                continue
+            for v, road_time_s, road_distance_m in roads[u]:
+                if time_s + road_time_s < times[v]:
+                    times[v] = time_s + road_time_s
+                    distances[v] = distances[u] + road_distance_m
+                    predecessors[v] = u + 1
+                    heapq.heappush(heap, (times[v], v))
+        time_table.append(times)
+        distance_table.append(distances)
+        path_table.append(predecessors)
+    return time_table, distance_table, path_table
+
+
+def write_table(path, table):
+    with open(path, "w") as file:
+        file.write("," + ",".join(str(i + 1) for i in range(len(table))) + "\n")
+        for i, row in enumerate(table):
+            file.write(str(i + 1) + "," + ",".join(str(value) for value in row) + "\n")
+
+
+def write_nodes(path, nodes, node_ids):
+    with open(path, "w") as file:
+        file.write("id,lon,lat\n")
+        for node_id in node_ids:
+            file.write("{},{:.6f},{:.6f}\n".format(node_id, *nodes[node_id - 1]))
+
+
+def write_demand(path, num_nodes, requests_per_hour, rng):
+    """Write the requests with uniformly random origins and destinations, at a constant rate (Poisson arrivals)."""
+
+    base_time = datetime.datetime.strptime(DATE, "%Y-%m-%d")
+    with open(path, "w") as file:
+        file.write("onid,dnid,ptime\n")
+        time_s = DEMAND_START_HOUR * 3600.0
+        while True:
+            time_s += rng.expovariate(requests_per_hour / 3600.0)
+            if time_s >= DEMAND_END_HOUR * 3600:
+                break
+            origin = rng.randint(1, num_nodes)
+            destination = rng.randint(1, num_nodes - 1)
+            destination += destination >= origin
+            request_time = base_time + datetime.timedelta(seconds=int(time_s))
+            file.write("{},{},{}\n".format(origin, destination, request_time.strftime("%Y-%m-%d %H:%M:%S")))
+
+
+def main():
+    """Generate a small synthetic city (grid road network and a few hours of uniform demand) in the format of the map
+    and taxi data, used by the benchmarks. The output is the same for the same arguments."""
+
+    stime = time.time()
+
+    if len(sys.argv) not in (2, 3):
+        print("[ERROR] Wrong arguments! \n"
+              "- Usage: python3 {} <path to output directory> [random seed] \n"
+              "- Example: python3 {} ./benchmark/synthetic-city \n".format(sys.argv[0], sys.argv[0]))
+        sys.exit(1)
+
+    path_to_output = sys.argv[1]
+    rng = random.Random(int(sys.argv[2]) if len(sys.argv) == 3 else 0)
+    os.makedirs(os.path.join(path_to_output, "map-data"), exist_ok=True)
+    os.makedirs(os.path.join(path_to_output, "taxi-data"), exist_ok=True)
+
+    nodes, roads = build_grid_city(GRID_WIDTH, GRID_HEIGHT, rng)
+    time_table, distance_table, path_table = compute_shortest_paths(nodes, roads)
+    write_nodes(os.path.join(path_to_output, "map-data", "nodes.csv"), nodes, range(1, len(nodes) + 1))
+    write_nodes(os.path.join(path_to_output, "map-data", "stations.csv"), nodes,
+                [y * GRID_WIDTH + x + 1 for y in range(1, GRID_HEIGHT, 3) for x in range(1, GRID_WIDTH, 3)])
+    write_table(os.path.join(path_to_output, "map-data", "mean-table.csv"), time_table)
+    write_table(os.path.join(path_to_output, "map-data", "dist-table.csv"), distance_table)
+    write_table(os.path.join(path_to_output, "map-data", "path-table.csv"), path_table)
+    write_demand(os.path.join(path_to_output, "taxi-data", "synthetic-city-{}.csv".format(DATE.replace("-", ""))),
+                 len(nodes), REQUESTS_PER_HOUR, rng)
+
+    print("[INFO] ({}s) Generated a synthetic city of {} nodes at {}.".format(
+        round(time.time() - stime, 2), len(nodes), path_to_output))
+
+
+if __name__ == "__main__":
+    main()
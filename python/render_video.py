@@ -9,6 +9,9 @@ import os
 import yaml
 import time
 import datetime
+from contextlib import closing
+
+from datalog_reader import read_frames
 
 
 root_path = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
@@ -145,7 +148,8 @@ def main():
     print("Rendering video of total {} frames (fps:{}, duration:{}s).\n Using datalog from {} ({})".format(
         num_frames, fps, viedo_duration, path_to_datalog, simulation_start_time_date))
 
-    with open(path_to_datalog) as file:
+    # The datalog is read frame by frame, in either the yaml or the binary format.
+    with closing(read_frames(path_to_datalog)) as frames:
         # Create the plot.
         fig = plt.figure(figsize=(w/DPI, h/DPI), dpi=DPI)
         ax = plt.axes(xlim=(0, w), ylim=(h, 0))
@@ -191,17 +195,11 @@ def main():
             print("Rendering Frame {} / {} of video (fps:{}, duration:{}s)...".format(
                 n + 1, num_frames, fps, viedo_duration))
 
-            # Load the yaml of the current frame.
-            string = ""
-            while True:
-                line = file.readline()
-                if not line:
-                    print("Reached the end of datalog file before expected! \n")
-                    sys.exit(1)
-                if line == "---\n":
-                    break
-                string += line
-            frame = yaml.safe_load(string)
+            # Load the current frame.
+            frame = next(frames, None)
+            if frame is None:
+                print("Reached the end of datalog file before expected! \n")
+                sys.exit(1)
             system_time_ms = frame["system_time_ms"]
 
             # Render vehicles.
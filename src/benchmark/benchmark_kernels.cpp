@@ -0,0 +1,243 @@
+#include "simulator/router.hpp"
+#include "dispatcher/dispatch_osp.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <unistd.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/// \brief Microbenchmarks of the routing and scheduling kernels, run on the bundled synthetic city
+/// (benchmark/synthetic-city, generated by python/generate_synthetic_city.py) so that they are comparable across
+/// code changes. Run from the root directory (or any directory under it) as "./build/benchmark_kernels", with the
+/// usual Google Benchmark flags (e.g. --benchmark_filter=Router --benchmark_format=json).
+
+namespace {
+/// \brief The max time an order may wait to be picked up and its max detour, as set in the demo config.
+constexpr int32_t max_pickup_wait_time_ms = 300 * 1000;
+constexpr float max_onboard_detour = 1.3;
+
+/// \brief The router of the synthetic city, loaded once.
+Router &getSyntheticCityRouter() {
+    static Router *router = [] {
+        const int MAXPATH = 250;
+        char buffer[MAXPATH];
+        getcwd(buffer, MAXPATH);
+        std::string build_file_directory = buffer;
+        auto root_directory = build_file_directory.substr(0, build_file_directory.find("AMoD2") + 5);
+        auto path_to_map_data = root_directory + "/benchmark/synthetic-city/map-data/";
+        return new Router(path_to_map_data + "nodes.csv", path_to_map_data + "stations.csv",
+                          path_to_map_data + "path-table.csv", path_to_map_data + "mean-table.csv",
+                          path_to_map_data + "dist-table.csv");
+    }();
+    return *router;
+}
+
+/// \brief Get the position of a random node.
+Pos getRandomNodePos(Router &router, std::mt19937 &rng) {
+    std::uniform_int_distribution<size_t> node_id_distribution(1, router.getNetworkNodes().size());
+    return router.getNodePos(node_id_distribution(rng));
+}
+
+/// \brief Add a pending order between two random nodes requested at the given time, with its time windows set as in
+/// Platform::GenerateOrders().
+Order &AddRandomOrder(OrderStore &orders, Router &router, std::mt19937 &rng, int32_t request_time_ms) {
+    Order order;
+    order.id = orders.size();
+    auto origin = getRandomNodePos(router, rng);
+    auto destination = origin;
+    while (destination.node_id == origin.node_id) { destination = getRandomNodePos(router, rng); }
+    order.origin_node_id = origin.node_id;
+    order.destination_node_id = destination.node_id;
+    order.request_time_ms = request_time_ms;
+    order.shortest_travel_time_ms = router(origin, destination, RoutingType::TIME_ONLY).duration_ms;
+    order.max_pickup_time_ms = order.request_time_ms + std::min(
+            max_pickup_wait_time_ms, static_cast<int32_t>(order.shortest_travel_time_ms * (2 - max_onboard_detour)));
+    order.max_dropoff_time_ms = order.request_time_ms + order.shortest_travel_time_ms + std::min(
+            max_pickup_wait_time_ms * 2, order.max_pickup_time_ms - order.request_time_ms
+            + static_cast<int32_t>(order.shortest_travel_time_ms * (max_onboard_detour - 1)));
+    orders.push_back(order);
+    return orders[order.id];
+}
+
+/// \brief Build a vehicle whose schedule serves num_of_orders orders, picked up in turn and dropped off (earliest
+/// first) only when the vehicle is full, so that its load reaches its capacity. The orders' time windows are wide
+/// enough for any schedule to be feasible.
+Vehicle BuildVehicleWithSchedule(OrderStore &orders, Router &router, std::mt19937 &rng,
+                                 size_t num_of_orders, size_t capacity) {
+    Vehicle vehicle;
+    vehicle.id = 0;
+    vehicle.capacity = capacity;
+    vehicle.pos = getRandomNodePos(router, rng);
+    vehicle.status = num_of_orders > 0 ? VehicleStatus::WORKING : VehicleStatus::IDLE;
+
+    auto add_waypoint = [&](const Order &order, WaypointOp op) {
+        auto pre_pos = vehicle.schedule.empty() ? vehicle.pos : vehicle.schedule.back().pos;
+        auto pos = router.getNodePos(op == WaypointOp::PICKUP ? order.origin_node_id : order.destination_node_id);
+        vehicle.schedule.push_back(Waypoint{pos, op, order.id, router(pre_pos, pos, RoutingType::TIME_ONLY)});
+    };
+    std::deque<size_t> onboard_order_ids;
+    for (auto i = 0; i < num_of_orders; i++) {
+        auto &order = AddRandomOrder(orders, router, rng, 0);
+        order.status = OrderStatus::PICKING;
+        order.max_pickup_time_ms = std::numeric_limits<int32_t>::max() / 2;
+        order.max_dropoff_time_ms = std::numeric_limits<int32_t>::max() / 2;
+        add_waypoint(order, WaypointOp::PICKUP);
+        onboard_order_ids.push_back(order.id);
+        if (onboard_order_ids.size() == capacity) {
+            add_waypoint(orders[onboard_order_ids.front()], WaypointOp::DROPOFF);
+            onboard_order_ids.pop_front();
+        }
+    }
+    for (auto order_id : onboard_order_ids) { add_waypoint(orders[order_id], WaypointOp::DROPOFF); }
+    return vehicle;
+}
+}
+
+/// \brief The lookup of the travel time between two random nodes.
+static void BM_RouterTimeOnly(benchmark::State &state) {
+    auto &router = getSyntheticCityRouter();
+    std::mt19937 rng(0);
+    std::vector<std::pair<Pos, Pos>> od_pairs;
+    for (auto i = 0; i < 1024; i++) {
+        od_pairs.emplace_back(getRandomNodePos(router, rng), getRandomNodePos(router, rng));
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto &[origin, destination] = od_pairs[i++ % od_pairs.size()];
+        benchmark::DoNotOptimize(router(origin, destination, RoutingType::TIME_ONLY));
+    }
+}
+BENCHMARK(BM_RouterTimeOnly);
+
+/// \brief The construction of the full route (steps and accumulated durations) between two random nodes.
+static void BM_RouterFullRoute(benchmark::State &state) {
+    auto &router = getSyntheticCityRouter();
+    std::mt19937 rng(0);
+    std::vector<std::pair<Pos, Pos>> od_pairs;
+    for (auto i = 0; i < 1024; i++) {
+        od_pairs.emplace_back(getRandomNodePos(router, rng), getRandomNodePos(router, rng));
+    }
+    size_t i = 0;
+    int64_t num_of_steps = 0;
+    for (auto _ : state) {
+        const auto &[origin, destination] = od_pairs[i++ % od_pairs.size()];
+        auto route = router(origin, destination, RoutingType::FULL_ROUTE);
+        num_of_steps += route.steps.size();
+        benchmark::DoNotOptimize(route);
+    }
+    state.counters["steps"] = benchmark::Counter(num_of_steps, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_RouterFullRoute);
+
+/// \brief The insertion of a new order into a schedule of range(0) orders, for a vehicle of capacity range(1).
+static void BM_ComputeScheduleOfInsertingOrderToVehicle(benchmark::State &state) {
+    auto &router = getSyntheticCityRouter();
+    std::mt19937 rng(0);
+    OrderStore orders;
+    auto vehicle = BuildVehicleWithSchedule(orders, router, rng, state.range(0), state.range(1));
+    std::vector<const Order *> new_orders;
+    for (auto i = 0; i < 64; i++) { new_orders.push_back(&AddRandomOrder(orders, router, rng, 0)); }
+    std::vector<std::vector<Waypoint>> basic_schedules = {vehicle.schedule};
+    size_t i = 0;
+    int64_t num_of_feasible_schedules = 0;
+    for (auto _ : state) {
+        auto result = ComputeScheduleOfInsertingOrderToVehicle(*new_orders[i++ % new_orders.size()], orders, vehicle,
+                                                               basic_schedules, 0, router);
+        num_of_feasible_schedules += result.feasible_schedules.size();
+        benchmark::DoNotOptimize(result);
+    }
+    state.counters["feasible_schedules"] =
+            benchmark::Counter(num_of_feasible_schedules, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ComputeScheduleOfInsertingOrderToVehicle)
+        ->ArgNames({"orders", "capacity"})
+        ->ArgsProduct({{0, 1, 2, 4, 6}, {2, 4, 8}});
+
+/// \brief The validation of a schedule of range(0) orders.
+static void BM_ValidateSchedule(benchmark::State &state) {
+    auto &router = getSyntheticCityRouter();
+    std::mt19937 rng(0);
+    OrderStore orders;
+    auto vehicle = BuildVehicleWithSchedule(orders, router, rng, state.range(0), 4);
+    for (auto _ : state) {
+        // (As in ComputeBasicSchedulesOfVehicle, "0, 0, Order{}" are placeholders when no order is inserted.)
+        auto [feasible, violation_type] =
+                ValidateSchedule(vehicle.schedule, 0, 0, Order{}, orders, vehicle, 0, router);
+        assert(feasible);
+        benchmark::DoNotOptimize(violation_type);
+    }
+}
+BENCHMARK(BM_ValidateSchedule)->ArgName("orders")->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+/// \brief The cost of a schedule of range(0) orders.
+static void BM_ComputeScheduleCost(benchmark::State &state) {
+    auto &router = getSyntheticCityRouter();
+    std::mt19937 rng(0);
+    OrderStore orders;
+    auto vehicle = BuildVehicleWithSchedule(orders, router, rng, state.range(0), 4);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ComputeScheduleCost(vehicle.schedule, orders, vehicle, 0));
+    }
+}
+BENCHMARK(BM_ComputeScheduleCost)->ArgName("orders")->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+/// \brief Advancing a vehicle by one frame on a full route, i.e. moving its route cursor and getting its position.
+static void BM_AdvanceRouteCursorByTime(benchmark::State &state) {
+    auto &router = getSyntheticCityRouter();
+    const auto &network_nodes = router.getNetworkNodes();
+    auto route = router(network_nodes.front(), network_nodes.back(), RoutingType::FULL_ROUTE);
+    const uint64_t frame_ms = 10 * 1000;
+    RouteCursor cursor;
+    uint64_t time_on_route_ms = 0;
+    for (auto _ : state) {
+        if (time_on_route_ms + frame_ms >= route.duration_ms) {
+            cursor = RouteCursor();
+            time_on_route_ms = 0;
+        }
+        AdvanceRouteCursorByTime(route, cursor, frame_ms);
+        time_on_route_ms += frame_ms;
+        benchmark::DoNotOptimize(GetPosAtRouteCursor(route, cursor));
+    }
+}
+BENCHMARK(BM_AdvanceRouteCursorByTime);
+
+/// \brief The assignment of the vehicle-trip pairs computed by OSP for range(0) idle vehicles and range(1) new orders.
+static void BM_IlpAssignment(benchmark::State &state) {
+    auto &router = getSyntheticCityRouter();
+    std::mt19937 rng(0);
+    OrderStore orders;
+    std::vector<Vehicle> vehicles(state.range(0));
+    for (auto i = 0; i < vehicles.size(); i++) {
+        vehicles[i].id = i;
+        vehicles[i].capacity = 4;
+        vehicles[i].pos = getRandomNodePos(router, rng);
+    }
+    FleetState fleet_state;
+    InitFleetState(fleet_state, vehicles);
+    std::vector<size_t> considered_order_ids;
+    for (auto i = 0; i < state.range(1); i++) {
+        considered_order_ids.push_back(AddRandomOrder(orders, router, rng, 0).id);
+    }
+
+    // Record the pairs once, as computed and scored by the dispatcher.
+    bool search_is_cut_short = false;
+    auto vehicle_trip_pairs = ComputeFeasibleVehicleTripPairs(considered_order_ids, orders, vehicles, fleet_state, 0,
+                                                              router, 1000, true, 0, search_is_cut_short);
+    ScoreVtPairsWithNumOfOrdersAndScheduleCost(vehicle_trip_pairs, orders, vehicles, 0);
+    IlpSolverEnvs solver_envs;
+    bool assignment_fell_back_to_greedy = false;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(IlpAssignment(vehicle_trip_pairs, considered_order_ids, orders, vehicles,
+                                               solver_envs, assignment_fell_back_to_greedy));
+    }
+    state.counters["pairs"] = vehicle_trip_pairs.size();
+}
+BENCHMARK(BM_IlpAssignment)
+        ->ArgNames({"vehicles", "orders"})
+        ->Args({10, 20})->Args({40, 40})->Args({100, 60})
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,158 @@
+#include "simulator/router.hpp"
+#include "simulator/demand_generator.hpp"
+#include "simulator/platform.hpp"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <fmt/format.h>
+#undef NDEBUG
+#include <assert.h>
+
+/// \brief The end-to-end benchmark of the whole simulation. Each scenario (a dispatcher, a rebalancer and a fleet size)
+/// runs Platform::RunSimulation() on the bundled synthetic city (benchmark/scenario_base.yml) in a child process, so
+/// that its peak memory is measured on its own. The wall time per simulated hour, the peak RSS and the service
+/// quality of the report are written to a csv file, one row per scenario.
+
+namespace {
+const std::vector<std::string> dispatchers = {"GI", "SBA", "OSP"};
+const std::vector<std::string> rebalancers = {"NONE", "RVS", "NPO"};
+const std::vector<size_t> fleet_sizes = {20, 40, 60};
+
+/// \brief Run the scenario in the current (child) process and write its timing and report to the pipe, as two lines
+/// of csv values.
+void RunScenario(const std::string &path_to_config_file,
+                 const std::string &root_directory,
+                 const std::string &dispatcher,
+                 const std::string &rebalancer,
+                 size_t fleet_size,
+                 int pipe_fd) {
+    auto s_time_ms = getTimeStampMs();
+    auto platform_config = load_platform_config(path_to_config_file, root_directory);
+    platform_config.mod_system_config.dispatch_config.dispatcher = dispatcher;
+    platform_config.mod_system_config.dispatch_config.rebalancer = rebalancer;
+    platform_config.mod_system_config.fleet_config.fleet_size = fleet_size;
+    platform_config.output_config.datalog_config.output_datalog = false;
+    platform_config.output_config.video_config.render_video = false;
+    auto simulated_hours = (platform_config.simulation_config.warmup_duration_min +
+                            platform_config.simulation_config.simulation_duration_min +
+                            platform_config.simulation_config.winddown_duration_min) / 60.0;
+
+    Router router{platform_config.data_file_path.path_to_network_nodes,
+                  platform_config.data_file_path.path_to_vehicle_stations,
+                  platform_config.data_file_path.path_to_shortest_path_table,
+                  platform_config.data_file_path.path_to_mean_travel_time_table,
+                  platform_config.data_file_path.path_to_travel_distance_table,
+                  platform_config.simulation_config.transposed_travel_time_table,
+                  platform_config.simulation_config.quantized_travel_tables};
+    DemandGenerator demand_generator{platform_config.data_file_path.path_to_taxi_data,
+                                     platform_config.simulation_config.simulation_start_time,
+                                     platform_config.mod_system_config.request_config.request_density};
+    Platform<decltype(router), decltype(demand_generator)> platform{std::move(platform_config),
+                                                                    std::move(router),
+                                                                    std::move(demand_generator)};
+    auto init_time_s = (getTimeStampMs() - s_time_ms) / 1000.0;
+    auto sim_start_time_ms = getTimeStampMs();
+    platform.RunSimulation(sim_start_time_ms, init_time_s);
+    auto wall_time_s = (getTimeStampMs() - sim_start_time_ms) / 1000.0;
+
+    const auto &report = platform.getReport();
+    auto result = fmt::format("{:.3f},{:.3f},{:.3f},{:.3f}\n",
+                              init_time_s, wall_time_s, wall_time_s / simulated_hours, report.main_sim_runtime_s);
+    result += fmt::format("{},{},{},{},{:.2f},{:.2f},{:.2f},{:.2f},{:.2f},{:.2f},{:.2f},{:.2f},{:.3f}\n",
+                          report.num_of_orders, report.num_of_walkaway_orders, report.num_of_complete_orders,
+                          report.num_of_onboard_orders, report.service_rate, report.avg_wait_s, report.avg_delay_s,
+                          report.avg_shortest_travel_s, report.total_dist_km, report.avg_dist_km,
+                          report.empty_dist_rate, report.rebl_dist_rate, report.avg_load_dist);
+    auto written = write(pipe_fd, result.data(), result.size());
+    assert(written == result.size() && "[ERROR] Failed to write the scenario result to the pipe!");
+}
+}
+
+int main(int argc, const char *argv[]) {
+    // Get the root directory.
+    const int MAXPATH = 250;
+    char buffer[MAXPATH];
+    getcwd(buffer, MAXPATH);
+    std::string build_file_directory = buffer;
+    auto root_directory = build_file_directory.substr(0, build_file_directory.find("AMoD2") + 5);
+
+    // Check the input arugment list.
+    std::string path_to_config_file = root_directory + "/benchmark/scenario_base.yml";
+    std::string path_to_output_result = root_directory + "/datalog-gitignore/benchmark-scenarios.csv";
+    if (argc > 3) {
+        fmt::print(stderr,
+                   "[ERROR] \n"
+                   "- Usage: <prog name> <arg1> <arg2>. \n"
+                   "  <arg1> (optional) is the path to the base config file of the scenarios. \n"
+                   "  <arg2> (optional) is the path to the output csv file. \n"
+                   "- Example: {} \"./benchmark/scenario_base.yml\" \"./benchmark-scenarios.csv\" \n", argv[0]);
+        return -1;
+    }
+    if (argc > 1) { path_to_config_file = argv[1]; }
+    if (argc > 2) { path_to_output_result = argv[2]; }
+    CheckFileExistence(path_to_config_file);
+
+    std::ofstream result_file(path_to_output_result);
+    assert(result_file.is_open() && "[ERROR] Failed to open the output result file!");
+    result_file << "dispatcher,rebalancer,fleet_size,init_time_s,wall_time_s,wall_s_per_sim_hour,main_sim_runtime_s,"
+                   "peak_rss_mb,orders,walkaway_orders,complete_orders,onboard_orders,service_rate,avg_wait_s,"
+                   "avg_delay_s,avg_shortest_travel_s,total_dist_km,avg_dist_km,empty_dist_rate,rebl_dist_rate,"
+                   "avg_load_dist\n";
+
+    auto num_of_scenarios = dispatchers.size() * rebalancers.size() * fleet_sizes.size();
+    auto scenario_count = 0;
+    for (const auto &dispatcher : dispatchers) {
+        for (const auto &rebalancer : rebalancers) {
+            for (auto fleet_size : fleet_sizes) {
+                scenario_count++;
+                std::fflush(stdout);
+                int pipe_fds[2];
+                auto pipe_created = pipe(pipe_fds) == 0;
+                assert(pipe_created && "[ERROR] Failed to create the pipe!");
+                auto pid = fork();
+                assert(pid >= 0 && "[ERROR] Failed to fork the scenario process!");
+                if (pid == 0) {
+                    // The child's progress bar and report are silenced, the parent reports the results.
+                    close(pipe_fds[0]);
+                    std::freopen("/dev/null", "w", stdout);
+                    RunScenario(path_to_config_file, root_directory, dispatcher, rebalancer, fleet_size, pipe_fds[1]);
+                    close(pipe_fds[1]);
+                    _exit(0);
+                }
+
+                // Read the result until the child exits, then get its peak RSS.
+                close(pipe_fds[1]);
+                std::string result;
+                char read_buffer[512];
+                ssize_t n;
+                while ((n = read(pipe_fds[0], read_buffer, sizeof(read_buffer))) > 0) { result.append(read_buffer, n); }
+                close(pipe_fds[0]);
+                int status;
+                struct rusage usage;
+                wait4(pid, &status, 0, &usage);
+                auto timing_end = result.find('\n');
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || timing_end == std::string::npos) {
+                    fmt::print(stderr, "[ERROR] ({}/{}) Scenario {} + {}, fleet = {} failed!\n",
+                               scenario_count, num_of_scenarios, dispatcher, rebalancer, fleet_size);
+                    continue;
+                }
+                auto timing = result.substr(0, timing_end);
+                auto report = result.substr(timing_end + 1);
+                auto peak_rss_mb = usage.ru_maxrss / 1024.0;  // ru_maxrss is in KB
+                result_file << fmt::format("{},{},{},{},{:.1f},{}", dispatcher, rebalancer, fleet_size, timing,
+                                           peak_rss_mb, report);
+                result_file.flush();
+                fmt::print("[INFO] ({}/{}) Scenario {} + {}, fleet = {}: {} (init, wall, wall per sim hour, main, s), "
+                           "peak_rss = {:.1f} MB.\n", scenario_count, num_of_scenarios, dispatcher, rebalancer,
+                           fleet_size, timing, peak_rss_mb);
+            }
+        }
+    }
+    fmt::print("[INFO] Wrote the results of the scenario benchmark to {}.\n", path_to_output_result);
+
+    return 0;
+}
@@ -12,12 +12,14 @@
 /// \param new_received_order_ids A vector holding indices to the new received orders in the current epoch.
 /// \param orders A vector of all orders.
 /// \param vehicles A vector of all vehicles.
+/// \param fleet_state The fleet state, mirroring the vehicles' hot fields.
 /// \param system_time_ms The current system time.
 /// \tparam router_func The router func that finds path between two poses.
 template <typename RouterFunc>
 void AssignOrdersThroughGreedyInsertion(const std::vector<size_t> &new_received_order_ids,
-                                                std::vector<Order> &orders,
+                                                OrderStore &orders,
                                                 std::vector<Vehicle> &vehicles,
+                                                FleetState &fleet_state,
                                                 uint64_t system_time_ms,
                                                 RouterFunc &router_func);
 
@@ -25,12 +27,14 @@ void AssignOrdersThroughGreedyInsertion(const std::vector<size_t> &new_received_
 /// \param order The order to be inserted.
 /// \param orders A vector of all orders.
 /// \param vehicles A vector of all vehicles.
+/// \param fleet_state The fleet state, mirroring the vehicles' hot fields.
 /// \param system_time_ms The current system time.
 /// \tparam router_func The router func that finds path between two poses.
 template <typename RouterFunc>
 void HeuristicInsertionOfOneOrder(Order &order,
-                        const std::vector<Order> &orders,
+                        const OrderStore &orders,
                         std::vector<Vehicle> &vehicles,
+                        FleetState &fleet_state,
                         uint64_t system_time_ms,
                         RouterFunc &router_func);
 
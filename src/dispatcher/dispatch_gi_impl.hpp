@@ -12,8 +12,9 @@
 
 template <typename RouterFunc>
 void AssignOrdersThroughGreedyInsertion(const std::vector<size_t> &new_received_order_ids,
-                                        std::vector<Order> &orders,
+                                        OrderStore &orders,
                                         std::vector<Vehicle> &vehicles,
+                                        FleetState &fleet_state,
                                         uint64_t system_time_ms,
                                         RouterFunc &router_func) {
     TIMER_START(t)
@@ -23,9 +24,10 @@ void AssignOrdersThroughGreedyInsertion(const std::vector<size_t> &new_received_
     }
 
     // Assigning new_received_orders in the first-in-first-out manner.
+    Profiler::Global().getDispatchCounters().num_of_considered_orders += new_received_order_ids.size();
     for (auto order_id : new_received_order_ids) {
         auto &order = orders[order_id];
-        HeuristicInsertionOfOneOrder(order, orders, vehicles, system_time_ms, router_func);
+        HeuristicInsertionOfOneOrder(order, orders, vehicles, fleet_state, system_time_ms, router_func);
     }
 
     if (DEBUG_PRINT) {
@@ -42,35 +44,43 @@ void AssignOrdersThroughGreedyInsertion(const std::vector<size_t> &new_received_
 
 template <typename RouterFunc>
 void HeuristicInsertionOfOneOrder(Order &order,
-                                const std::vector<Order> &orders,
+                                const OrderStore &orders,
                                 std::vector<Vehicle> &vehicles,
+                                FleetState &fleet_state,
                                 uint64_t system_time_ms,
                                 RouterFunc &router_func) {
 
     SchedulingResult scheduling_result;
-    // 1. Iterate through all vehicles and find the one with the least cost.
-    for (const auto &vehicle : vehicles) {
-        if (!PassQuickCheck(order, vehicle, system_time_ms, router_func)) { continue; }
-        std::vector<std::vector<Waypoint>> basic_schedules;
-        basic_schedules.push_back(vehicle.schedule);
-        auto result_this_vehicle = ComputeScheduleOfInsertingOrderToVehicle(
-                order, orders, vehicle, basic_schedules, system_time_ms, router_func);
-        if (!result_this_vehicle.success) { continue; }
-        // Compute the score as minus the increased schedule cost. The smaller the cost, the higher the score.
-        result_this_vehicle.score = ComputeScheduleCost(vehicle.schedule, orders, vehicle, system_time_ms)
-                                    - result_this_vehicle.best_schedule_cost_ms;
-        assert(result_this_vehicle.score <= 0);
-        if (result_this_vehicle.score > scheduling_result.score) {
-            scheduling_result = std::move(result_this_vehicle);
+    // 1. Iterate through all vehicles passing the quick check and find the one with the least cost.
+    //    (Timed as the pair generation of GI, with the scores computed along.)
+    {
+        ScopedPhaseTimer t(ProfilerPhase::PAIR_GEN);
+        auto quick_check_bitmap = QuickCheckOrderAgainstFleet(order, fleet_state, system_time_ms, router_func);
+        for (const auto &vehicle : vehicles) {
+            if (!VehicleBitmapHas(quick_check_bitmap, vehicle.id)) { continue; }
+            std::vector<std::vector<Waypoint>> basic_schedules;
+            basic_schedules.push_back(vehicle.schedule);
+            auto result_this_vehicle = ComputeScheduleOfInsertingOrderToVehicle(
+                    order, orders, vehicle, basic_schedules, system_time_ms, router_func);
+            if (!result_this_vehicle.success) { continue; }
+            Profiler::Global().getDispatchCounters().AddVtPairs(1);
+            // Compute the score as minus the increased schedule cost. The smaller the cost, the higher the score.
+            result_this_vehicle.score = ComputeScheduleCost(vehicle.schedule, orders, vehicle, system_time_ms)
+                                        - result_this_vehicle.best_schedule_cost_ms;
+            assert(result_this_vehicle.score <= 0);
+            if (result_this_vehicle.score > scheduling_result.score) {
+                scheduling_result = std::move(result_this_vehicle);
+            }
         }
     }
 
     // 2. Insert the order to the best vehicle and update the vehicle's schedule.
     if (scheduling_result.success) {
+        ScopedPhaseTimer t(ProfilerPhase::ROUTE_BUILD);
         order.status = OrderStatus::PICKING;
         auto &best_vehicle = vehicles[scheduling_result.vehicle_id];
         auto &best_schedule = scheduling_result.feasible_schedules[scheduling_result.best_schedule_idx];
-        UpdVehicleScheduleAndBuildRoute(best_vehicle, best_schedule, router_func);
+        UpdVehicleScheduleAndBuildRoute(best_vehicle, fleet_state, best_schedule, router_func);
 
 //        if (DEBUG_PRINT) {
 //            fmt::print("            +Assigned Order #{} to Vehicle #{}, with a schedule has {} waypoints.\n",
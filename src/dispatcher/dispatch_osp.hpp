@@ -16,56 +16,72 @@
 /// ignored. Based on this complete feasible solution space (called optimal schedule pool, each optimal schedule
 /// representing a vehicle-trip pair), the optimal assignment policy could be found by an ILP solver.
 /// \param new_received_order_ids A vector holding indices to the new received orders in the current epoch.
+/// \param active_order_ids A vector holding indices to the orders not yet complete or walkaway, in ascending order.
 /// \param orders A vector of all orders.
 /// \param vehicles A vector of all vehicles.
+/// \param fleet_state The fleet state, mirroring the vehicles' hot fields.
 /// \param system_time_ms The current system time.
 /// \tparam router_func The router func that finds path between two poses.
+/// \param ilp_solver_envs The solver environments of the ILP threads, kept across epochs.
+/// \param latency_budget_ms The max computational time allowed for this epoch (0 means no limit). When it is set,
+/// the trip search stops early (larger trips first), the ILP gets the remaining time and the greedy result is used
+/// for the parts that are not solved in time.
+/// \return True if the latency budget expired at this epoch.
 template <typename RouterFunc>
-void AssignOrdersThroughOptimalSchedulePoolAssign(const std::vector<size_t> &new_received_order_ids,
-                                                 std::vector<Order> &orders,
+bool AssignOrdersThroughOptimalSchedulePoolAssign(const std::vector<size_t> &new_received_order_ids,
+                                                 const std::vector<size_t> &active_order_ids,
+                                                 OrderStore &orders,
                                                  std::vector<Vehicle> &vehicles,
+                                                 FleetState &fleet_state,
                                                  uint64_t system_time_ms,
-                                                 RouterFunc &router_func);
+                                                 RouterFunc &router_func,
+                                                 IlpSolverEnvs &ilp_solver_envs,
+                                                 uint64_t latency_budget_ms = 0);
 
 /// \brief Compute all possible vehicle-trip pairs and return the result as a vector.
 /// \details Each element in the vector indicates a feasible assignment (insertion) of trip to vehicle.
-/// A trip is a group of orders that can be assigned to the same vehicle.
+/// A trip is a group of orders that can be assigned to the same vehicle. Trips are computed incrementally for
+/// increasing ride-sharing trip sizes, one size at a time for the whole fleet, so that a deadline only drops the
+/// larger trips.
 /// \param considered_order_ids A vector holding indices to the orders considered by OSP in the current epoch.
 /// \param orders A vector of all orders.
 /// \param vehicles A vector of all vehicles.
+/// \param fleet_state The fleet state, mirroring the vehicles' hot fields.
 /// \param system_time_ms The current system time.
 /// \tparam router_func The router func that finds path between two poses.
 /// \param cutoff_time_for_a_size_k_trip_search_per_vehicle_ms A time out setting to prevent potential dead loop.
+/// \param search_deadline_time_stamp_ms The time stamp after which no more size k (k>1) trips are searched
+/// (0 means no deadline).
+/// \param search_is_cut_short Set to true if the search stopped at the deadline.
 template <typename RouterFunc>
 std::vector<SchedulingResult> ComputeFeasibleVehicleTripPairs(const std::vector<size_t> &considered_order_ids,
-                                                              const std::vector<Order> &orders,
+                                                              const OrderStore &orders,
                                                               const std::vector<Vehicle> &vehicles,
+                                                              const FleetState &fleet_state,
                                                               uint64_t system_time_ms,
                                                               RouterFunc &router_func,
                                                               int cutoff_time_for_a_size_k_trip_search_per_vehicle_ms,
-                                                              bool enable_reoptimization);
+                                                              bool enable_reoptimization,
+                                                              std::time_t search_deadline_time_stamp_ms,
+                                                              bool &search_is_cut_short);
 
-/// \brief Compute all possible trips for the given vehicle, along with the optimal schedule for each trip.
-/// \details All possible trips are computed incrementally for increasing ride-sharing trip sizes.
-/// \param considered_order_ids A vector holding indices to the orders considered by OSP in the current epoch.
-/// \param orders A vector of all orders.
-/// \param vehicle The vehicle to be computed.
-/// \param system_time_ms The current system time.
-/// \tparam router_func The router func that finds path between two poses.
-template <typename RouterFunc>
-std::vector<SchedulingResult> ComputeFeasibleTripsForOneVehicle(const std::vector<size_t> &considered_order_ids,
-                                                                const std::vector<Order> &orders,
-                                                                const Vehicle &vehicle,
-                                                                uint64_t system_time_ms,
-                                                                RouterFunc &router_func,
-                                                                int cutoff_time_for_a_size_k_trip_search_ms,
-                                                                bool enable_reoptimization);
+/// \brief Get the vehicle-trip pairs that are always available to the given vehicle, i.e., its basic schedule
+/// (the "empty assign" option in ILP) and its current working schedule (if reoptimization is enabled).
+inline std::vector<SchedulingResult> ComputeBasicVtPairsOfVehicle(
+        const OrderStore &orders,
+        const Vehicle &vehicle,
+        const std::vector<std::vector<Waypoint>> &basic_schedules,
+        uint64_t system_time_ms,
+        bool enable_reoptimization);
 
 /// \brief Compute all possible size 1 trips for the given vehicle.
 /// \details Each element in the vector indicates a feasible assignment (insertion) of order to vehicle.
+/// \param quick_check_bitmaps The quick check result of each considered order against the fleet. Only the orders for
+/// which the vehicle passes the quick check are tried.
 template <typename RouterFunc>
 std::vector<SchedulingResult> ComputeSize1TripsForOneVehicle(const std::vector<size_t> &considered_order_ids,
-                                                             const std::vector<Order> &orders,
+                                                             const std::vector<VehicleBitmap> &quick_check_bitmaps,
+                                                             const OrderStore &orders,
                                                              const Vehicle &vehicle,
                                                              const std::vector<std::vector<Waypoint>> &basic_schedules,
                                                              uint64_t system_time_ms,
@@ -77,7 +93,7 @@ template <typename RouterFunc>
 std::vector<SchedulingResult> ComputeSizeKTripsForOneVehicle(
         const std::vector<size_t> &considered_order_ids,
         const std::vector<SchedulingResult> &feasible_trips_of_size_k_minus_1,
-        const std::vector<Order> &orders,
+        const OrderStore &orders,
         const Vehicle &vehicle,
         uint64_t system_time_ms,
         RouterFunc &router_func,
@@ -86,7 +102,7 @@ std::vector<SchedulingResult> ComputeSizeKTripsForOneVehicle(
 /// \brief Get the basic schedules of the given vehicle, each of which only includes waypoints
 /// of dropping off onboard orders.
 template <typename RouterFunc>
-std::vector<std::vector<Waypoint>> ComputeBasicSchedulesOfVehicle(const std::vector<Order> &orders,
+std::vector<std::vector<Waypoint>> ComputeBasicSchedulesOfVehicle(const OrderStore &orders,
                                                                   const Vehicle &vehicle,
                                                                   uint64_t system_time_ms,
                                                                   RouterFunc &router_func,
@@ -96,7 +112,9 @@ std::vector<std::vector<Waypoint>> ComputeBasicSchedulesOfVehicle(const std::vec
 /// \details This is only needed when using GreedyAssignment, cause the assignment of GreedyAssignment cannot guarantee
 /// that there is no conflict match when enable reoptimazation.)
 template <typename RouterFunc>
-void UpdScheduleForVehiclesHavingOrdersRemoved(std::vector<Vehicle> &vehicles, RouterFunc &router_func);
+void UpdScheduleForVehiclesHavingOrdersRemoved(std::vector<Vehicle> &vehicles,
+                                               FleetState &fleet_state,
+                                               RouterFunc &router_func);
 
 // Implementation is put in a separate file for clarity and maintainability.
 #include "dispatch_osp_impl.hpp"
\ No newline at end of file
@@ -7,16 +7,23 @@
 #include "dispatch_osp.hpp"
 
 #include <fmt/format.h>
+
+#include <numeric>
+
 #undef NDEBUG
 #include <assert.h>
 
 
 template <typename RouterFunc>
-void AssignOrdersThroughOptimalSchedulePoolAssign(const std::vector<size_t> &new_received_order_ids,
-                                                  std::vector<Order> &orders,
+bool AssignOrdersThroughOptimalSchedulePoolAssign(const std::vector<size_t> &new_received_order_ids,
+                                                  const std::vector<size_t> &active_order_ids,
+                                                  OrderStore &orders,
                                                   std::vector<Vehicle> &vehicles,
+                                                  FleetState &fleet_state,
                                                   uint64_t system_time_ms,
-                                                  RouterFunc &router_func) {
+                                                  RouterFunc &router_func,
+                                                  IlpSolverEnvs &ilp_solver_envs,
+                                                  uint64_t latency_budget_ms) {
     TIMER_START(t)
 
     // Some general settings.
@@ -30,6 +37,14 @@ void AssignOrdersThroughOptimalSchedulePoolAssign(const std::vector<size_t> &new
         // Orders that have been assigned vehicles are guaranteed to be served to ensure a good user experience.
         // The objective of assignment could be further improved if this guarantee is abandoned.
     const bool ensure_ilp_assigning_orders_that_are_picking = true;
+        // When a latency budget is set, the trip search may use this share of it, and the rest is left for the ILP.
+    const float share_of_latency_budget_for_trip_search = 0.7;
+    std::time_t search_deadline_time_stamp_ms = 0;
+    std::time_t dispatch_deadline_time_stamp_ms = 0;
+    if (latency_budget_ms > 0) {
+        search_deadline_time_stamp_ms = t + latency_budget_ms * share_of_latency_budget_for_trip_search;
+        dispatch_deadline_time_stamp_ms = t + latency_budget_ms;
+    }
 
     // 1. Get the list of considered orders, normally including all picking and pending orders.
     //    If re-assigning picking orders to different vehicles is enabled, all picking and pending orders are considered.
@@ -37,7 +52,8 @@ void AssignOrdersThroughOptimalSchedulePoolAssign(const std::vector<size_t> &new
     if (!enable_reoptimization) {
         considered_order_ids = new_received_order_ids;
     } else {
-        for (auto &order: orders) {
+        for (auto order_id : active_order_ids) {
+            const auto &order = orders[order_id];
             if (order.status == OrderStatus::PICKING || order.status == OrderStatus::PENDING) {
                 considered_order_ids.push_back(order.id);
             }
@@ -50,27 +66,45 @@ void AssignOrdersThroughOptimalSchedulePoolAssign(const std::vector<size_t> &new
     }
 
     // 2. Compute all feasible vehicle trip pairs, each indicating the orders in the trip can be served by the vehicle.
+    bool trip_search_is_cut_short = false;
     auto feasible_vehicle_trip_pairs =
-            ComputeFeasibleVehicleTripPairs(considered_order_ids, orders, vehicles, system_time_ms, router_func,
-                                            cutoff_time_for_a_size_k_trip_search_per_vehicle_ms, enable_reoptimization);
+            ComputeFeasibleVehicleTripPairs(considered_order_ids, orders, vehicles, fleet_state, system_time_ms,
+                                            router_func, cutoff_time_for_a_size_k_trip_search_per_vehicle_ms,
+                                            enable_reoptimization, search_deadline_time_stamp_ms,
+                                            trip_search_is_cut_short);
+    Profiler::Global().getDispatchCounters().num_of_considered_orders += considered_order_ids.size();
+    CountVtPairsOfEachTripSize(feasible_vehicle_trip_pairs);
 
     // 3. Score the candidate vehicle_trip_pairs.
     ScoreVtPairsWithNumOfOrdersAndScheduleCost(feasible_vehicle_trip_pairs, orders, vehicles, system_time_ms);
 
     // 4. Compute the assignment policy based on the scores, indicating which vehicle to pick which trip.
+    //    (With a latency budget, the ILP only gets the remaining time and falls back to greedy when it runs out.)
+    int32_t ilp_time_limit_ms = 0;
+    if (latency_budget_ms > 0) {
+        ilp_time_limit_ms = std::max(static_cast<std::time_t>(1), dispatch_deadline_time_stamp_ms - getTimeStampMs());
+    }
+    bool assignment_fell_back_to_greedy = false;
     auto selected_vehicle_trip_pair_indices = IlpAssignment(feasible_vehicle_trip_pairs,
-                                                            considered_order_ids, orders, vehicles,
-                                                            ensure_ilp_assigning_orders_that_are_picking);
+                                                            considered_order_ids, orders, vehicles, ilp_solver_envs,
+                                                            assignment_fell_back_to_greedy,
+                                                            ensure_ilp_assigning_orders_that_are_picking,
+                                                            ilp_time_limit_ms);
 //    auto selected_vehicle_trip_pair_indices = GreedyAssignment(feasible_vehicle_trip_pairs);
+    bool latency_budget_expired =
+            latency_budget_ms > 0 && (trip_search_is_cut_short || getTimeStampMs() >= dispatch_deadline_time_stamp_ms);
 
     // 5. Update the assigned vehicles' schedules and the considered orders' statuses.
     for (auto order_id : considered_order_ids) { orders[order_id].status = OrderStatus::PENDING; }
     UpdScheduleForVehiclesInSelectedVtPairs(feasible_vehicle_trip_pairs, selected_vehicle_trip_pair_indices,
-                                            orders, vehicles, router_func);
+                                            orders, vehicles, fleet_state, router_func);
 
-//    // 6. Update the schedule of vehicles, of which the assigned (picking) orders are reassigned to other vehicles.
-//    //    (This is only needed when using GreedyAssignment.)
-//    if (enable_reoptimization) { UpdScheduleForVehiclesHavingOrdersRemoved(vehicles, router_func); }
+    // 6. Update the schedule of vehicles, of which the assigned (picking) orders are reassigned to other vehicles.
+    //    (This is only needed when using GreedyAssignment, i.e., when the ILP falls back to greedy for any component,
+    //    at the deadline or when the solver finds no solution or fails, or when the trip search is cut short.)
+    if (enable_reoptimization && (latency_budget_expired || assignment_fell_back_to_greedy)) {
+        UpdScheduleForVehiclesHavingOrdersRemoved(vehicles, fleet_state, router_func);
+    }
 
     if (DEBUG_PRINT) {
         int num_of_assigned_orders = 0;
@@ -78,89 +112,99 @@ void AssignOrdersThroughOptimalSchedulePoolAssign(const std::vector<size_t> &new
             if (orders[order_id].status == OrderStatus::PICKING) { num_of_assigned_orders++; }
         }
         fmt::print("            +Assigned orders: {}", num_of_assigned_orders);
+        if (latency_budget_expired) { fmt::print(" (latency budget expired)"); }
+        if (assignment_fell_back_to_greedy) { fmt::print(" (assigned greedily in part)"); }
         TIMER_END(t)
     }
+    return latency_budget_expired;
 }
 
 template <typename RouterFunc>
 std::vector<SchedulingResult> ComputeFeasibleVehicleTripPairs(const std::vector<size_t> &considered_order_ids,
-                                                              const std::vector<Order> &orders,
+                                                              const OrderStore &orders,
                                                               const std::vector<Vehicle> &vehicles,
+                                                              const FleetState &fleet_state,
                                                               uint64_t system_time_ms,
                                                               RouterFunc &router_func,
                                                               int cutoff_time_for_a_size_k_trip_search_per_vehicle_ms,
-                                                              bool enable_reoptimization) {
-    TIMER_START(t)
+                                                              bool enable_reoptimization,
+                                                              std::time_t search_deadline_time_stamp_ms,
+                                                              bool &search_is_cut_short) {
+    ScopedPhaseTimer t(ProfilerPhase::PAIR_GEN);
     if (DEBUG_PRINT) {
         fmt::print("                *Computing feasible vehicle trip pairs...");
     }
     std::vector<SchedulingResult> feasible_vehicle_trip_pairs;
+    search_is_cut_short = false;
+
+    // 1. Compute trips of size 1 and the basic vt_pairs of each vehicle. They are always computed, to make sure that
+    //    each vehicle has an option in ILP and the picking orders can still be assigned.
+    //    (The quick check of each considered order is done once against the whole fleet.)
+    auto quick_check_bitmaps =
+            QuickCheckOrdersAgainstFleet(considered_order_ids, orders, fleet_state, system_time_ms, router_func);
+    std::vector<std::vector<SchedulingResult>> feasible_trips_of_size_k_minus_1(vehicles.size());
     for (const auto &vehicle : vehicles) {
-        auto feasible_trips_for_this_vehicle =
-                ComputeFeasibleTripsForOneVehicle(considered_order_ids, orders, vehicle, system_time_ms, router_func,
-                                                  cutoff_time_for_a_size_k_trip_search_per_vehicle_ms,
-                                                  enable_reoptimization);
+        auto basic_schedules =
+                ComputeBasicSchedulesOfVehicle(orders, vehicle, system_time_ms, router_func, enable_reoptimization);
+        auto feasible_trips_of_size_1 = ComputeSize1TripsForOneVehicle(considered_order_ids, quick_check_bitmaps,
+                                                                       orders, vehicle, basic_schedules,
+                                                                       system_time_ms, router_func);
+        feasible_vehicle_trip_pairs.insert(feasible_vehicle_trip_pairs.end(),
+                                           feasible_trips_of_size_1.begin(), feasible_trips_of_size_1.end());
+        feasible_trips_of_size_k_minus_1[vehicle.id] = std::move(feasible_trips_of_size_1);
+        auto basic_vt_pairs = ComputeBasicVtPairsOfVehicle(orders, vehicle, basic_schedules, system_time_ms,
+                                                           enable_reoptimization);
         feasible_vehicle_trip_pairs.insert(feasible_vehicle_trip_pairs.end(),
-                                           feasible_trips_for_this_vehicle.begin(),
-                                           feasible_trips_for_this_vehicle.end());
+                                           std::make_move_iterator(basic_vt_pairs.begin()),
+                                           std::make_move_iterator(basic_vt_pairs.end()));
+    }
+
+    // 2. Compute trips of size k (k >= 2), for all vehicles with the same k before moving to k + 1.
+    bool has_trips_of_size_k_minus_1 = true;
+    while (has_trips_of_size_k_minus_1 && !search_is_cut_short) {
+        has_trips_of_size_k_minus_1 = false;
+        for (const auto &vehicle : vehicles) {
+            if (feasible_trips_of_size_k_minus_1[vehicle.id].empty()) { continue; }
+            if (search_deadline_time_stamp_ms > 0 && getTimeStampMs() >= search_deadline_time_stamp_ms) {
+                search_is_cut_short = true;
+                break;
+            }
+            auto feasible_trips_of_size_k =
+                    ComputeSizeKTripsForOneVehicle(considered_order_ids, feasible_trips_of_size_k_minus_1[vehicle.id],
+                                                   orders, vehicle, system_time_ms, router_func,
+                                                   cutoff_time_for_a_size_k_trip_search_per_vehicle_ms);
+            feasible_vehicle_trip_pairs.insert(feasible_vehicle_trip_pairs.end(),
+                                               feasible_trips_of_size_k.begin(), feasible_trips_of_size_k.end());
+            if (!feasible_trips_of_size_k.empty()) { has_trips_of_size_k_minus_1 = true; }
+            feasible_trips_of_size_k_minus_1[vehicle.id] = std::move(feasible_trips_of_size_k);
+        }
     }
 
     if (DEBUG_PRINT) {
+        if (search_is_cut_short) { fmt::print(" (cut short at the deadline)"); }
         TIMER_END(t)
     }
     return feasible_vehicle_trip_pairs;
 }
 
-template <typename RouterFunc>
-std::vector<SchedulingResult> ComputeFeasibleTripsForOneVehicle(const std::vector<size_t> &considered_order_ids,
-                                                                const std::vector<Order> &orders,
-                                                                const Vehicle &vehicle,
-                                                                uint64_t system_time_ms,
-                                                                RouterFunc &router_func,
-                                                                int cutoff_time_for_a_size_k_trip_search_ms,
-                                                                bool enable_reoptimization) {
-
-//    if (DEBUG_PRINT) {
-//        fmt::print("                    +Computing feasible vehicle trip pairs for Vehicle #{}...\n",
-//                   vehicle.id);
-//    }
-
-    std::vector<SchedulingResult> feasible_trips_for_this_vehicle;
-
-    // 1. Get the basic schedules of the vehicle.
-    auto basic_schedules =
-            ComputeBasicSchedulesOfVehicle(orders, vehicle, system_time_ms, router_func, enable_reoptimization);
-
-    // 2. Compute trips of size 1.
-    std::vector<SchedulingResult> feasible_trips_of_size_1 = ComputeSize1TripsForOneVehicle(considered_order_ids,
-                                                                                            orders,
-                                                                                            vehicle,
-                                                                                            basic_schedules,
-                                                                                            system_time_ms,
-                                                                                            router_func);
-    feasible_trips_for_this_vehicle.insert(feasible_trips_for_this_vehicle.end(),
-                                           feasible_trips_of_size_1.begin(), feasible_trips_of_size_1.end());
-    // 3. Compute trips of size k (k >= 2).
-    std::vector<SchedulingResult> feasible_trips_of_size_k_minus_1 = feasible_trips_of_size_1;
-    while(feasible_trips_of_size_k_minus_1.size() != 0) {
-        auto feasible_trips_of_size_k =
-                ComputeSizeKTripsForOneVehicle(considered_order_ids, feasible_trips_of_size_k_minus_1, orders, vehicle,
-                                               system_time_ms, router_func, cutoff_time_for_a_size_k_trip_search_ms);
-        feasible_trips_for_this_vehicle.insert(feasible_trips_for_this_vehicle.end(),
-                                               feasible_trips_of_size_k.begin(), feasible_trips_of_size_k.end());
-        feasible_trips_of_size_k_minus_1 = feasible_trips_of_size_k;
-    }
+inline std::vector<SchedulingResult> ComputeBasicVtPairsOfVehicle(
+        const OrderStore &orders,
+        const Vehicle &vehicle,
+        const std::vector<std::vector<Waypoint>> &basic_schedules,
+        uint64_t system_time_ms,
+        bool enable_reoptimization) {
+    std::vector<SchedulingResult> basic_vt_pairs;
 
-    // 4. Add the basic schedule of the vehicle, which denotes the "empty assign" option in ILP.
+    // 1. Add the basic schedule of the vehicle, which denotes the "empty assign" option in ILP.
     SchedulingResult basic_vt_pair;
     basic_vt_pair.success = true;
     basic_vt_pair.vehicle_id = vehicle.id;
     basic_vt_pair.feasible_schedules = basic_schedules;
     basic_vt_pair.best_schedule_idx = 0;
     basic_vt_pair.best_schedule_cost_ms = ComputeScheduleCost(basic_schedules[0], orders, vehicle, system_time_ms);
-    feasible_trips_for_this_vehicle.push_back(std::move(basic_vt_pair));
+    basic_vt_pairs.push_back(std::move(basic_vt_pair));
 
-    // 5. Add the current working schedule, to have a double ensure about ensure_ilp_assigning_orders_that_are_picking.
+    // 2. Add the current working schedule, to have a double ensure about ensure_ilp_assigning_orders_that_are_picking.
     if (enable_reoptimization) {
         SchedulingResult current_working_vt_pair;
         current_working_vt_pair.success = true;
@@ -172,15 +216,16 @@ std::vector<SchedulingResult> ComputeFeasibleTripsForOneVehicle(const std::vecto
         current_working_vt_pair.best_schedule_idx = 0;
         current_working_vt_pair.best_schedule_cost_ms =
                 ComputeScheduleCost(vehicle.schedule, orders, vehicle, system_time_ms);
-        feasible_trips_for_this_vehicle.push_back(std::move(current_working_vt_pair));
+        basic_vt_pairs.push_back(std::move(current_working_vt_pair));
     }
 
-    return feasible_trips_for_this_vehicle;
+    return basic_vt_pairs;
 }
 
 template <typename RouterFunc>
 std::vector<SchedulingResult> ComputeSize1TripsForOneVehicle(const std::vector<size_t> &considered_order_ids,
-                                                             const std::vector<Order> &orders,
+                                                             const std::vector<VehicleBitmap> &quick_check_bitmaps,
+                                                             const OrderStore &orders,
                                                              const Vehicle &vehicle,
                                                              const std::vector<std::vector<Waypoint>> &basic_schedules,
                                                              uint64_t system_time_ms,
@@ -192,9 +237,10 @@ std::vector<SchedulingResult> ComputeSize1TripsForOneVehicle(const std::vector<s
 
     std::vector<SchedulingResult> feasible_trips_of_size_1;
 
-    for (auto order_id : considered_order_ids) {
+    for (size_t i = 0; i < considered_order_ids.size(); i++) {
+        if (!VehicleBitmapHas(quick_check_bitmaps[i], vehicle.id)) { continue; }
+        auto order_id = considered_order_ids[i];
         const auto &order = orders[order_id];
-        if (!PassQuickCheck(order, vehicle, system_time_ms, router_func)) { continue; }
         auto scheduling_result_this_pair = ComputeScheduleOfInsertingOrderToVehicle(
                 order, orders, vehicle, basic_schedules, system_time_ms, router_func);
         if (scheduling_result_this_pair.success) {
@@ -213,7 +259,7 @@ template <typename RouterFunc>
 std::vector<SchedulingResult> ComputeSizeKTripsForOneVehicle(
         const std::vector<size_t> &considered_order_ids,
         const std::vector<SchedulingResult> &feasible_trips_of_size_k_minus_1,
-        const std::vector<Order> &orders,
+        const OrderStore &orders,
         const Vehicle &vehicle,
         uint64_t system_time_ms,
         RouterFunc &router_func,
@@ -293,7 +339,7 @@ std::vector<SchedulingResult> ComputeSizeKTripsForOneVehicle(
 }
 
 template <typename RouterFunc>
-std::vector<std::vector<Waypoint>> ComputeBasicSchedulesOfVehicle(const std::vector<Order> &orders,
+std::vector<std::vector<Waypoint>> ComputeBasicSchedulesOfVehicle(const OrderStore &orders,
                                                                   const Vehicle &vehicle,
                                                                   uint64_t system_time_ms,
                                                                   RouterFunc &router_func,
@@ -335,9 +381,9 @@ std::vector<std::vector<Waypoint>> ComputeBasicSchedulesOfVehicle(const std::vec
             new_basic_schedule.push_back(wp);
             pre_pos = wp.pos;
         }
-        // Terms "0, 0, orders[0]" here are meaningless, they are served as default values for the following function.
+        // Terms "0, 0, Order{}" here are meaningless, they are served as default values for the following function.
         auto [feasible_this_schedule, violation_type] = ValidateSchedule(
-                new_basic_schedule, 0, 0, orders[0], orders, vehicle, system_time_ms, router_func);
+                new_basic_schedule, 0, 0, Order{}, orders, vehicle, system_time_ms, router_func);
         if (feasible_this_schedule) { basic_schedules.push_back(std::move(new_basic_schedule)); }
     }
 
@@ -346,8 +392,10 @@ std::vector<std::vector<Waypoint>> ComputeBasicSchedulesOfVehicle(const std::vec
 }
 
 template <typename RouterFunc>
-void UpdScheduleForVehiclesHavingOrdersRemoved(std::vector<Vehicle> &vehicles, RouterFunc &router_func) {
-    TIMER_START(t)
+void UpdScheduleForVehiclesHavingOrdersRemoved(std::vector<Vehicle> &vehicles,
+                                               FleetState &fleet_state,
+                                               RouterFunc &router_func) {
+    ScopedPhaseTimer t(ProfilerPhase::ROUTE_BUILD);
     if (DEBUG_PRINT) {
         auto num_of_changed_vehicles = 0;
         for (auto &vehicle: vehicles) {
@@ -372,7 +420,7 @@ void UpdScheduleForVehiclesHavingOrdersRemoved(std::vector<Vehicle> &vehicles, R
                     pre_pos = wp.pos;
                 }
             }
-            UpdVehicleScheduleAndBuildRoute(vehicle, basic_schedule, router_func);
+            UpdVehicleScheduleAndBuildRoute(vehicle, fleet_state, basic_schedule, router_func);
         }
     }
 
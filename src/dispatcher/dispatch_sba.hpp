@@ -13,26 +13,32 @@
 /// \param new_received_order_ids A vector holding indices to the new received orders in the current epoch.
 /// \param orders A vector of all orders.
 /// \param vehicles A vector of all vehicles.
+/// \param fleet_state The fleet state, mirroring the vehicles' hot fields.
 /// \param system_time_ms The current system time.
 /// \tparam router_func The router func that finds path between two poses.
+/// \param ilp_solver_envs The solver environments of the ILP threads, kept across epochs.
 template <typename RouterFunc>
 void AssignOrdersThroughSingleRequestBatchAssign(const std::vector<size_t> &new_received_order_ids,
-                                                 std::vector<Order> &orders,
+                                                 OrderStore &orders,
                                                  std::vector<Vehicle> &vehicles,
+                                                 FleetState &fleet_state,
                                                  uint64_t system_time_ms,
-                                                 RouterFunc &router_func);
+                                                 RouterFunc &router_func,
+                                                 IlpSolverEnvs &ilp_solver_envs);
 
 /// \brief Compute all possible vehicle-order pairs and return the result as a vector.
 /// \details Each element in the vector indicates a feasible assignment (insertion) of order to vehicle.
 /// \param new_received_order_ids A vector holding indices to the new received orders in the current epoch.
 /// \param orders A vector of all orders.
 /// \param vehicles A vector of all vehicles.
+/// \param fleet_state The fleet state, mirroring the vehicles' hot fields.
 /// \param system_time_ms The current system time.
 /// \tparam router_func The router func that finds path between two poses.
 template <typename RouterFunc>
 std::vector<SchedulingResult> ComputeFeasibleVehicleOrderPairs(const std::vector<size_t> &new_received_order_ids,
-                                                               const std::vector<Order> &orders,
+                                                               const OrderStore &orders,
                                                                const std::vector<Vehicle> &vehicles,
+                                                               const FleetState &fleet_state,
                                                                uint64_t system_time_ms,
                                                                RouterFunc &router_func);
 
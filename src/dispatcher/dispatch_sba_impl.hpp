@@ -12,10 +12,12 @@
 
 template <typename RouterFunc>
 void AssignOrdersThroughSingleRequestBatchAssign(const std::vector<size_t> &new_received_order_ids,
-                                                 std::vector<Order> &orders,
+                                                 OrderStore &orders,
                                                  std::vector<Vehicle> &vehicles,
+                                                 FleetState &fleet_state,
                                                  uint64_t system_time_ms,
-                                                 RouterFunc &router_func) {
+                                                 RouterFunc &router_func,
+                                                 IlpSolverEnvs &ilp_solver_envs) {
 
     TIMER_START(t)
     if (DEBUG_PRINT) {
@@ -25,19 +27,24 @@ void AssignOrdersThroughSingleRequestBatchAssign(const std::vector<size_t> &new_
 
     // 1. Compute all possible vehicle order pairs, each indicating that the order can be served by the vehicle.
     auto feasible_vehicle_order_pairs = ComputeFeasibleVehicleOrderPairs(new_received_order_ids, orders, vehicles,
-                                                                         system_time_ms, router_func);
+                                                                         fleet_state, system_time_ms, router_func);
+    Profiler::Global().getDispatchCounters().num_of_considered_orders += new_received_order_ids.size();
+    CountVtPairsOfEachTripSize(feasible_vehicle_order_pairs);
 
     // 2. Score the candidate vehicle_order_pairs.
     ScoreVtPairsWithNumOfOrdersAndScheduleCost(feasible_vehicle_order_pairs, orders, vehicles, system_time_ms);
 
     // 3. Compute the assignment policy based on the scores, indicating which vehicle to pick which order.
+    //    (Only new orders are considered, so no schedule needs to be repaired if the ILP falls back to greedy.)
+    bool assignment_fell_back_to_greedy = false;
     auto selected_vehicle_order_pair_indices = IlpAssignment(feasible_vehicle_order_pairs,
-                                                             new_received_order_ids, orders, vehicles);
+                                                             new_received_order_ids, orders, vehicles,
+                                                             ilp_solver_envs, assignment_fell_back_to_greedy);
 //    auto selected_vehicle_order_pair_indices = GreedyAssignment(feasible_vehicle_order_pairs);
 
     // 4. Update the assigned vehicles' schedules and the assigned orders' statuses.
     UpdScheduleForVehiclesInSelectedVtPairs(feasible_vehicle_order_pairs, selected_vehicle_order_pair_indices,
-                                            orders, vehicles, router_func);
+                                            orders, vehicles, fleet_state, router_func);
 
     if (DEBUG_PRINT) {
         int num_of_assigned_orders = 0;
@@ -53,21 +60,25 @@ void AssignOrdersThroughSingleRequestBatchAssign(const std::vector<size_t> &new_
 
 template <typename RouterFunc>
 std::vector<SchedulingResult> ComputeFeasibleVehicleOrderPairs(const std::vector<size_t> &new_received_order_ids,
-                                                               const std::vector<Order> &orders,
+                                                               const OrderStore &orders,
                                                                const std::vector<Vehicle> &vehicles,
+                                                               const FleetState &fleet_state,
                                                                uint64_t system_time_ms,
                                                                RouterFunc &router_func) {
-    TIMER_START(t)
+    ScopedPhaseTimer t(ProfilerPhase::PAIR_GEN);
     if (DEBUG_PRINT) {
         fmt::print("                *Computing feasible vehicle order pairs...");
     }
     std::vector<SchedulingResult> feasible_vehicle_order_pairs;
 
-    // 1. Compute the feasible orders for each vehicle.
+    // 1. Compute the feasible orders for each vehicle, among the orders for which it passes the quick check.
+    auto quick_check_bitmaps =
+            QuickCheckOrdersAgainstFleet(new_received_order_ids, orders, fleet_state, system_time_ms, router_func);
     for (const auto &vehicle: vehicles) {
         std::vector<std::vector<Waypoint>> basic_schedules;
         basic_schedules.push_back(vehicle.schedule);
         auto feasible_vehicle_order_pairs_for_this_vehicle = ComputeSize1TripsForOneVehicle(new_received_order_ids,
+                                                                                            quick_check_bitmaps,
                                                                                             orders,
                                                                                             vehicle,
                                                                                             basic_schedules,
@@ -5,115 +5,421 @@
 #include "ilp_assign.hpp"
 #include "gurobi_c++.h"
 
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
 #undef NDEBUG
 #include <assert.h>
 
-std::vector<size_t> IlpAssignment(const std::vector<SchedulingResult> &vehicle_trip_pairs,
-                                  const std::vector<size_t> &considered_order_ids,
-                                  const std::vector<Order> &orders,
-                                  const std::vector<Vehicle> &vehicles,
-                                  bool ensure_assigning_orders_that_are_picking) {
-    TIMER_START(t)
-    if (DEBUG_PRINT) {
-        fmt::print("                *ILP assignment with {} pairs...", vehicle_trip_pairs.size());
+IlpSolverEnvs::IlpSolverEnvs(size_t _num_of_threads) : envs_(std::max(_num_of_threads, static_cast<size_t>(1))) {}
+
+IlpSolverEnvs::~IlpSolverEnvs() = default;
+
+GRBEnv &IlpSolverEnvs::getEnv(size_t thread_idx) {
+    auto &env = envs_[thread_idx];
+    if (!env) {
+        auto new_env = std::make_unique<GRBEnv>(true);
+        new_env->set("LogToConsole", "0");
+        new_env->set("Threads", "1");
+        new_env->start();
+        env = std::move(new_env);
     }
+    return *env;
+}
+
+/// \brief Greedily assign one component, in decreasing score. Used when the solver runs out of time or fails.
+/// \details If picking orders must be assigned, each vehicle having picking orders is first given its best pair that
+/// keeps them all (and takes no picking order of other vehicles), as AssignSingleVehicleComponent does for a single
+/// vehicle. Such a pair always exists with reoptimization, as the vehicle's current schedule is one of its pairs.
+static std::vector<size_t> GreedyAssignmentOfOneComponent(const AssignmentComponent &component,
+                                                          const std::vector<SchedulingResult> &vehicle_trip_pairs,
+                                                          const std::vector<size_t> &considered_order_ids,
+                                                          const OrderStore &orders,
+                                                          const std::vector<Vehicle> &vehicles,
+                                                          bool ensure_assigning_orders_that_are_picking) {
     std::vector<size_t> selected_vehicle_trip_pair_indices;
-    if (vehicle_trip_pairs.size() == 0) { return selected_vehicle_trip_pair_indices; }
+    std::unordered_set<size_t> selected_vehicle_ids;
+    std::unordered_set<size_t> selected_order_ids;
+    auto greedily_select_pairs = [&](std::vector<size_t> pair_indices) {
+        std::sort(pair_indices.begin(), pair_indices.end(), [&vehicle_trip_pairs](size_t a, size_t b) {
+            return SortVehicleTripPairs(vehicle_trip_pairs[a], vehicle_trip_pairs[b]);
+        });
+        for (auto i : pair_indices) {
+            const auto &vt_pair = vehicle_trip_pairs[i];
+            if (selected_vehicle_ids.count(vt_pair.vehicle_id) > 0) { continue; }
+            if (std::any_of(vt_pair.trip_ids.begin(), vt_pair.trip_ids.end(), [&selected_order_ids](size_t order_id) {
+                return selected_order_ids.count(order_id) > 0;
+            })) { continue; }
+            selected_vehicle_ids.insert(vt_pair.vehicle_id);
+            selected_order_ids.insert(vt_pair.trip_ids.begin(), vt_pair.trip_ids.end());
+            selected_vehicle_trip_pair_indices.push_back(i);
+        }
+    };
 
-    try {
-        // 1. Create an environment.
-        GRBEnv env = GRBEnv(true);
-        env.set("LogToConsole", "0");
-        env.start();
+    // 1. Keep the picking orders with their vehicles.
+    if (ensure_assigning_orders_that_are_picking) {
+        std::unordered_set<size_t> component_order_ids;
+        for (auto j : component.considered_order_indices) { component_order_ids.insert(considered_order_ids[j]); }
+        std::unordered_map<size_t, size_t> vehicle_id_of_picking_order;
+        std::unordered_map<size_t, size_t> num_of_picking_orders_of_vehicle;
+        for (auto vehicle_id : component.vehicle_ids) {
+            for (const auto &wp : vehicles[vehicle_id].schedule) {
+                if (wp.op == WaypointOp::PICKUP && component_order_ids.count(wp.order_id) > 0 &&
+                    orders[wp.order_id].status == OrderStatus::PICKING) {
+                    vehicle_id_of_picking_order[wp.order_id] = vehicle_id;
+                    num_of_picking_orders_of_vehicle[vehicle_id]++;
+                }
+            }
+        }
+        std::vector<size_t> pair_indices_keeping_picking_orders;
+        for (auto i : component.vehicle_trip_pair_indices) {
+            const auto &vt_pair = vehicle_trip_pairs[i];
+            auto iter = num_of_picking_orders_of_vehicle.find(vt_pair.vehicle_id);
+            if (iter == num_of_picking_orders_of_vehicle.end()) { continue; }
+            size_t num_of_own_picking_orders = 0;
+            bool takes_picking_orders_of_other_vehicles = false;
+            for (auto order_id : vt_pair.trip_ids) {
+                auto owner = vehicle_id_of_picking_order.find(order_id);
+                if (owner == vehicle_id_of_picking_order.end()) { continue; }
+                if (owner->second == vt_pair.vehicle_id) {
+                    num_of_own_picking_orders++;
+                } else {
+                    takes_picking_orders_of_other_vehicles = true;
+                }
+            }
+            if (num_of_own_picking_orders == iter->second && !takes_picking_orders_of_other_vehicles) {
+                pair_indices_keeping_picking_orders.push_back(i);
+            }
+        }
+        greedily_select_pairs(std::move(pair_indices_keeping_picking_orders));
+    }
+
+    // 2. Assign the rest greedily.
+    greedily_select_pairs(component.vehicle_trip_pair_indices);
+    return selected_vehicle_trip_pair_indices;
+}
+
+/// \brief Solve the ILP model of one component with the given Gurobi environment (one environment per thread).
+/// If a time limit is given (> 0) and the solver stops at it, the best solution found so far is used, or the greedy
+/// assignment if no solution has been found. The greedy assignment is also used if the solver fails. In both cases,
+/// fell_back_to_greedy is set to true.
+static std::vector<size_t> IlpAssignmentOfOneComponent(const AssignmentComponent &component,
+                                                       const std::vector<SchedulingResult> &vehicle_trip_pairs,
+                                                       const std::vector<size_t> &considered_order_ids,
+                                                       const OrderStore &orders,
+                                                       const std::vector<Vehicle> &vehicles,
+                                                       GRBEnv &env,
+                                                       bool ensure_assigning_orders_that_are_picking,
+                                                       double time_limit_s,
+                                                       bool &fell_back_to_greedy) {
+    auto greedy_assignment = [&]() {
+        fell_back_to_greedy = true;
+        return GreedyAssignmentOfOneComponent(component, vehicle_trip_pairs, considered_order_ids, orders, vehicles,
+                                              ensure_assigning_orders_that_are_picking);
+    };
+    std::vector<size_t> selected_vehicle_trip_pair_indices;
+    const auto &pair_indices = component.vehicle_trip_pair_indices;
+    const auto &order_indices = component.considered_order_indices;
 
-        // 2. Create an empty model.
+    try {
+        // 1. Create an empty model.
         GRBModel model = GRBModel(env);
 
-        // 3. Create variables
+        // 2. Create variables
         //     (lower_bound, upper_bounds, objective_coefficient (zero here and set later), variable_type)
         std::vector<GRBVar> var_vt_pair; // var_vt_pair[i] = 1 indicates selecting the i_th vehicle_trip_pair.
-        for (auto i = 0; i < vehicle_trip_pairs.size(); i++) {
+        for (auto i = 0; i < pair_indices.size(); i++) {
             var_vt_pair.push_back(model.addVar(0.0, 1.0, 0.0, GRB_BINARY));
         }
         std::vector<GRBVar> var_order;  // var_order[j] = 0 indicates assigning the i_th order in the list.
-        for (auto j = 0; j < considered_order_ids.size(); j++) {
+        for (auto j = 0; j < order_indices.size(); j++) {
             var_order.push_back(model.addVar(0.0, 1.0, 0.0, GRB_BINARY));
         }
 
-        // 4. Set objective: maximize Σ var_vt_pair[i] * score(vt_pair).
+        // 3. Set objective: maximize Σ var_vt_pair[i] * score(vt_pair).
         GRBLinExpr obj = 0.0;
-        for (auto i = 0; i < vehicle_trip_pairs.size(); i++) {
-            obj += var_vt_pair[i] * (vehicle_trip_pairs[i].score);
+        for (auto i = 0; i < pair_indices.size(); i++) {
+            obj += var_vt_pair[i] * (vehicle_trip_pairs[pair_indices[i]].score);
         }
         model.setObjective(obj, GRB_MAXIMIZE);
 
-        // 5. Add constraints.
-        // Add constraint 1: each vehicle (v) can only be assigned at most one schedule (trip).
-        //     Σ var_vt_pair[i] * Θ_vt(v) = 1, ∀ v ∈ V. (Θ_vt(v) = 1 if v is in vt).
-        for (const auto &vehicle : vehicles) {
-            GRBLinExpr con_this_vehicle = 0.0;
-            for (auto i = 0; i < vehicle_trip_pairs.size(); i++) {
-                if (vehicle_trip_pairs[i].vehicle_id == vehicle.id) {
-                    con_this_vehicle += var_vt_pair[i];
-                }
+        // 4. Add constraints. The pairs are grouped by vehicles and orders in one pass, instead of scanning all pairs
+        //    for each vehicle and each order.
+        std::unordered_map<size_t, size_t> local_vehicle_idx;
+        for (auto v = 0; v < component.vehicle_ids.size(); v++) { local_vehicle_idx[component.vehicle_ids[v]] = v; }
+        std::unordered_map<size_t, size_t> local_order_idx;
+        for (auto j = 0; j < order_indices.size(); j++) { local_order_idx[considered_order_ids[order_indices[j]]] = j; }
+        std::vector<GRBLinExpr> con_vehicles(component.vehicle_ids.size(), 0.0);
+        std::vector<GRBLinExpr> con_orders(order_indices.size(), 0.0);
+        for (auto i = 0; i < pair_indices.size(); i++) {
+            const auto &vt_pair = vehicle_trip_pairs[pair_indices[i]];
+            con_vehicles[local_vehicle_idx[vt_pair.vehicle_id]] += var_vt_pair[i];
+            for (auto order_id : vt_pair.trip_ids) {
+                auto iter = local_order_idx.find(order_id);
+                if (iter != local_order_idx.end()) { con_orders[iter->second] += var_vt_pair[i]; }
             }
-            model.addConstr(con_this_vehicle == 1);
         }
+        // Add constraint 1: each vehicle (v) can only be assigned at most one schedule (trip).
+        //     Σ var_vt_pair[i] * Θ_vt(v) = 1, ∀ v ∈ V. (Θ_vt(v) = 1 if v is in vt).
+        for (auto &con_this_vehicle : con_vehicles) { model.addConstr(con_this_vehicle == 1); }
         // Add constraint 2: each order/request (r) can only be assigned to at most one vehicle.
         //     Σ var_vt_pair[i] * Θ_vt(r) + var_order[j] = 1, ∀ r ∈ R. (Θ_vt(order) = 1 if r is in vt).
-        for (auto j = 0; j < considered_order_ids.size(); j++) {
-            const auto &order = orders[considered_order_ids[j]];
-            GRBLinExpr con_this_order = 0.0;
-            for (auto i = 0; i < vehicle_trip_pairs.size(); i++) {
-                const auto &trip_ids_this_vt = vehicle_trip_pairs[i].trip_ids;
-                if (std::find(trip_ids_this_vt.begin(), trip_ids_this_vt.end(), order.id) != trip_ids_this_vt.end()) {
-                    con_this_order += var_vt_pair[i];
-                }
-            }
-            con_this_order += var_order[j];
-            model.addConstr(con_this_order == 1);
+        for (auto j = 0; j < order_indices.size(); j++) {
+            con_orders[j] += var_order[j];
+            model.addConstr(con_orders[j] == 1);
         }
         // Add constraint 3: no currently picking order is ignored.
         //     var_order[j] = 0, if OrderStatus==PICKING, ∀ r ∈ R.
         if (ensure_assigning_orders_that_are_picking) {
-            for (auto j = 0; j < considered_order_ids.size(); j++) {
-                if (orders[considered_order_ids[j]].status == OrderStatus::PICKING) {
+            for (auto j = 0; j < order_indices.size(); j++) {
+                if (orders[considered_order_ids[order_indices[j]]].status == OrderStatus::PICKING) {
                     model.addConstr(var_order[j] == 0);
                 }
             }
         }
 
-        // 6. Optimize model.
+        // 5. Optimize model.
+        if (time_limit_s > 0) { model.set(GRB_DoubleParam_TimeLimit, time_limit_s); }
         model.optimize();
+        if (model.get(GRB_IntAttr_SolCount) == 0) { return greedy_assignment(); }
 
-        // 7. Get the result.
-        for (auto i = 0; i < vehicle_trip_pairs.size(); i++) {
-            if (var_vt_pair[i].get(GRB_DoubleAttr_X) == 1){ selected_vehicle_trip_pair_indices.push_back(i); }
+        // 6. Get the result.
+        for (auto i = 0; i < pair_indices.size(); i++) {
+            if (var_vt_pair[i].get(GRB_DoubleAttr_X) == 1) {
+                selected_vehicle_trip_pair_indices.push_back(pair_indices[i]);
+            }
         }
 
         // Check the results of orders
         if (ensure_assigning_orders_that_are_picking) {
-            for (auto j = 0; j < considered_order_ids.size(); j++) {
-                if (orders[considered_order_ids[j]].status == OrderStatus::PICKING) {
+            for (auto j = 0; j < order_indices.size(); j++) {
+                if (orders[considered_order_ids[order_indices[j]]].status == OrderStatus::PICKING) {
                     assert(var_order[j].get(GRB_DoubleAttr_X) == 0
                            && "Order that was picking is not assigned at this epoch!");
                 }
             }
         }
 
-//        fmt::print("\n[GUROBI] Objective:{}\n", model.get(GRB_DoubleAttr_ObjVal));
-
     } catch(GRBException e) {
-        fmt::print("\n[GUROBI] Error code = {} ({}).\n", e.getErrorCode(), e.getMessage());
+        fmt::print("\n[GUROBI] Error code = {} ({}). The component is assigned greedily.\n",
+                   e.getErrorCode(), e.getMessage());
+        return greedy_assignment();
     } catch(...) {
-        fmt::print("[GUROBI] Exception during optimization\n");
+        fmt::print("\n[GUROBI] Exception during optimization. The component is assigned greedily.\n");
+        return greedy_assignment();
     }
-    if (DEBUG_PRINT) { TIMER_END(t) }
     return selected_vehicle_trip_pair_indices;
 }
 
-std::vector<size_t> GreedyAssignment(std::vector<SchedulingResult> &vehicle_trip_pairs) {
+std::vector<size_t> IlpAssignment(const std::vector<SchedulingResult> &vehicle_trip_pairs,
+                                  const std::vector<size_t> &considered_order_ids,
+                                  const OrderStore &orders,
+                                  const std::vector<Vehicle> &vehicles,
+                                  IlpSolverEnvs &solver_envs,
+                                  bool &assignment_fell_back_to_greedy,
+                                  bool ensure_assigning_orders_that_are_picking,
+                                  int32_t time_limit_ms) {
+    ScopedPhaseTimer phase_timer(ProfilerPhase::ILP);
     TIMER_START(t)
+    const std::time_t deadline_time_stamp_ms = time_limit_ms > 0 ? t + time_limit_ms : 0;
+    std::vector<size_t> selected_vehicle_trip_pair_indices;
+    assignment_fell_back_to_greedy = false;
+    if (vehicle_trip_pairs.size() == 0) {
+        if (DEBUG_PRINT) {
+            fmt::print("                *ILP assignment with 0 pairs...");
+            TIMER_END(t)
+        }
+        return selected_vehicle_trip_pair_indices;
+    }
+
+    // 1. Split the problem into independent components.
+    auto components = ComputeConnectedComponentsOfVtPairs(vehicle_trip_pairs, considered_order_ids, vehicles);
+
+    // 2. Decide the trivial components (only one vehicle) directly, and collect the others for the solver.
+    std::vector<size_t> ilp_component_indices;
+    for (auto c = 0; c < components.size(); c++) {
+        if (components[c].vehicle_ids.size() == 1) {
+            selected_vehicle_trip_pair_indices.push_back(AssignSingleVehicleComponent(
+                    components[c], vehicle_trip_pairs, considered_order_ids, orders,
+                    ensure_assigning_orders_that_are_picking));
+        } else {
+            ilp_component_indices.push_back(c);
+        }
+    }
+    auto &dispatch_counters = Profiler::Global().getDispatchCounters();
+    for (auto c : ilp_component_indices) {
+        // One variable per pair and per order, and one constraint per vehicle and per order (and per picking order).
+        const auto &component = components[c];
+        dispatch_counters.num_of_ilp_variables +=
+                component.vehicle_trip_pair_indices.size() + component.considered_order_indices.size();
+        dispatch_counters.num_of_ilp_constraints +=
+                component.vehicle_ids.size() + component.considered_order_indices.size();
+        if (ensure_assigning_orders_that_are_picking) {
+            for (auto j : component.considered_order_indices) {
+                if (orders[considered_order_ids[j]].status == OrderStatus::PICKING) {
+                    dispatch_counters.num_of_ilp_constraints++;
+                }
+            }
+        }
+    }
+    if (DEBUG_PRINT) {
+        fmt::print("                *ILP assignment with {} pairs ({} components, {} solved by ILP)...",
+                   vehicle_trip_pairs.size(), components.size(), ilp_component_indices.size());
+    }
+
+    // 3. Solve the non-trivial components concurrently. Each thread uses its own Gurobi environment (kept across
+    //    epochs), and the components are taken from a shared counter, the largest ones first. With a time limit, each
+    //    model gets the time left, and the components reached after the deadline are assigned greedily. If a thread's
+    //    environment fails to start, its components are assigned greedily.
+    std::sort(ilp_component_indices.begin(), ilp_component_indices.end(), [&components](size_t a, size_t b) {
+        return components[a].vehicle_trip_pair_indices.size() > components[b].vehicle_trip_pair_indices.size();
+    });
+    std::vector<std::vector<size_t>> selected_indices_of_components(ilp_component_indices.size());
+    std::atomic<size_t> next_component = 0;
+    std::atomic<size_t> num_of_greedy_components = 0;
+    auto solve_components = [&](size_t thread_idx) {
+        GRBEnv *env = nullptr;
+        try {
+            env = &solver_envs.getEnv(thread_idx);
+        } catch(GRBException e) {
+            fmt::print("\n[GUROBI] Error code = {} ({}). The components are assigned greedily.\n",
+                       e.getErrorCode(), e.getMessage());
+        } catch(...) {
+            fmt::print("\n[GUROBI] Exception when starting. The components are assigned greedily.\n");
+        }
+        for (auto k = next_component++; k < ilp_component_indices.size(); k = next_component++) {
+            const auto &component = components[ilp_component_indices[k]];
+            auto time_left_ms = deadline_time_stamp_ms > 0 ? deadline_time_stamp_ms - getTimeStampMs() : 0;
+            if (!env || (deadline_time_stamp_ms > 0 && time_left_ms <= 0)) {
+                selected_indices_of_components[k] = GreedyAssignmentOfOneComponent(
+                        component, vehicle_trip_pairs, considered_order_ids, orders, vehicles,
+                        ensure_assigning_orders_that_are_picking);
+                num_of_greedy_components++;
+                continue;
+            }
+            bool fell_back_to_greedy = false;
+            selected_indices_of_components[k] = IlpAssignmentOfOneComponent(
+                    component, vehicle_trip_pairs, considered_order_ids, orders, vehicles, *env,
+                    ensure_assigning_orders_that_are_picking, time_left_ms / 1000.0, fell_back_to_greedy);
+            if (fell_back_to_greedy) { num_of_greedy_components++; }
+        }
+    };
+    auto num_of_threads = std::min(solver_envs.getNumOfThreads(), ilp_component_indices.size());
+    std::vector<std::thread> threads;
+    for (auto i = 1; i < num_of_threads; i++) { threads.emplace_back(solve_components, i); }
+    if (num_of_threads > 0) { solve_components(0); }
+    for (auto &thread : threads) { thread.join(); }
+
+    for (const auto &selected_indices : selected_indices_of_components) {
+        selected_vehicle_trip_pair_indices.insert(selected_vehicle_trip_pair_indices.end(),
+                                                  selected_indices.begin(), selected_indices.end());
+    }
+    std::sort(selected_vehicle_trip_pair_indices.begin(), selected_vehicle_trip_pair_indices.end());
+    assignment_fell_back_to_greedy = num_of_greedy_components > 0;
+
+    if (DEBUG_PRINT) {
+        if (num_of_greedy_components > 0) {
+            fmt::print(" ({} assigned greedily)", num_of_greedy_components.load());
+        }
+        TIMER_END(t)
+    }
+    return selected_vehicle_trip_pair_indices;
+}
+
+std::vector<AssignmentComponent> ComputeConnectedComponentsOfVtPairs(
+        const std::vector<SchedulingResult> &vehicle_trip_pairs,
+        const std::vector<size_t> &considered_order_ids,
+        const std::vector<Vehicle> &vehicles) {
+    // Nodes [0, num_of_vehicles) are vehicles (by id), and nodes [num_of_vehicles, ...) are the considered orders.
+    const auto num_of_vehicles = vehicles.size();
+    std::unordered_map<size_t, size_t> order_idx;
+    for (auto j = 0; j < considered_order_ids.size(); j++) { order_idx[considered_order_ids[j]] = j; }
+    std::vector<size_t> parent(num_of_vehicles + considered_order_ids.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find_root = [&parent](size_t node) {
+        while (parent[node] != node) {
+            parent[node] = parent[parent[node]];
+            node = parent[node];
+        }
+        return node;
+    };
+
+    // 1. Link each vehicle with the orders in its pairs.
+    std::vector<bool> vehicle_has_pairs(num_of_vehicles, false);
+    for (const auto &vt_pair : vehicle_trip_pairs) {
+        vehicle_has_pairs[vt_pair.vehicle_id] = true;
+        for (auto order_id : vt_pair.trip_ids) {
+            auto iter = order_idx.find(order_id);
+            if (iter == order_idx.end()) { continue; }
+            auto root_v = find_root(vt_pair.vehicle_id);
+            auto root_r = find_root(num_of_vehicles + iter->second);
+            if (root_v != root_r) { parent[root_r] = root_v; }
+        }
+    }
+
+    // 2. Collect the components, each of which is identified by the root of its vehicles.
+    std::vector<AssignmentComponent> components;
+    std::unordered_map<size_t, size_t> component_idx_of_root;
+    for (const auto &vehicle : vehicles) {
+        if (!vehicle_has_pairs[vehicle.id]) { continue; }
+        auto root = find_root(vehicle.id);
+        if (component_idx_of_root.count(root) == 0) {
+            component_idx_of_root[root] = components.size();
+            components.emplace_back();
+        }
+        components[component_idx_of_root[root]].vehicle_ids.push_back(vehicle.id);
+    }
+    for (auto j = 0; j < considered_order_ids.size(); j++) {
+        auto iter = component_idx_of_root.find(find_root(num_of_vehicles + j));
+        if (iter != component_idx_of_root.end()) { components[iter->second].considered_order_indices.push_back(j); }
+    }
+    for (auto i = 0; i < vehicle_trip_pairs.size(); i++) {
+        auto c = component_idx_of_root[find_root(vehicle_trip_pairs[i].vehicle_id)];
+        components[c].vehicle_trip_pair_indices.push_back(i);
+    }
+    return components;
+}
+
+size_t AssignSingleVehicleComponent(const AssignmentComponent &component,
+                                    const std::vector<SchedulingResult> &vehicle_trip_pairs,
+                                    const std::vector<size_t> &considered_order_ids,
+                                    const OrderStore &orders,
+                                    bool ensure_assigning_orders_that_are_picking) {
+    assert(component.vehicle_ids.size() == 1 && !component.vehicle_trip_pair_indices.empty());
+    std::vector<size_t> picking_order_ids;
+    if (ensure_assigning_orders_that_are_picking) {
+        for (auto j : component.considered_order_indices) {
+            if (orders[considered_order_ids[j]].status == OrderStatus::PICKING) {
+                picking_order_ids.push_back(considered_order_ids[j]);
+            }
+        }
+    }
+    // With only one vehicle, the vehicle constraint selects exactly one pair, and the order constraints hold for any
+    // single pair. So the optimal solution is the best pair that serves all picking orders.
+    size_t best_pair_idx = component.vehicle_trip_pair_indices[0];
+    bool best_pair_serves_picking_orders = false;
+    for (auto i : component.vehicle_trip_pair_indices) {
+        const auto &trip_ids = vehicle_trip_pairs[i].trip_ids;
+        bool serves_picking_orders = std::all_of(
+                picking_order_ids.begin(), picking_order_ids.end(), [&trip_ids](size_t order_id) {
+                    return std::find(trip_ids.begin(), trip_ids.end(), order_id) != trip_ids.end();
+                });
+        if (serves_picking_orders > best_pair_serves_picking_orders ||
+            (serves_picking_orders == best_pair_serves_picking_orders &&
+             vehicle_trip_pairs[i].score > vehicle_trip_pairs[best_pair_idx].score)) {
+            best_pair_idx = i;
+            best_pair_serves_picking_orders = serves_picking_orders;
+        }
+    }
+    assert(best_pair_serves_picking_orders || picking_order_ids.empty());
+    return best_pair_idx;
+}
+
+std::vector<size_t> GreedyAssignment(std::vector<SchedulingResult> &vehicle_trip_pairs) {
+    ScopedPhaseTimer t(ProfilerPhase::ILP);
     if (DEBUG_PRINT) {
         fmt::print("                *Greedy assignment with {} pairs...", vehicle_trip_pairs.size());
     }
@@ -6,13 +6,77 @@
 
 #include "scheduling.hpp"
 
+#include <memory>
+
+class GRBEnv;
+
+/// \brief The Gurobi environments of the threads solving the ILP components, one per thread.
+/// \details An environment is started when its thread first solves a model, and is then kept for the whole
+/// simulation, so that the solver (and its license) is not set up again at every epoch.
+class IlpSolverEnvs {
+  public:
+    /// \brief Constructor. The components are solved by at most _num_of_threads threads.
+    explicit IlpSolverEnvs(size_t _num_of_threads = 1);
+
+    /// \brief Destructor.
+    ~IlpSolverEnvs();
+
+    /// \brief Delete the other constructors. Rule of five.
+    IlpSolverEnvs(const IlpSolverEnvs &other) = delete;
+    IlpSolverEnvs(IlpSolverEnvs &&other) = delete;
+    IlpSolverEnvs &operator=(const IlpSolverEnvs &other) = delete;
+    IlpSolverEnvs &operator=(IlpSolverEnvs &&other) = delete;
+
+    /// \brief Get the number of threads.
+    size_t getNumOfThreads() const { return envs_.size(); }
+
+    /// \brief Get the environment of the thread, started at the first call. Only called from that thread.
+    /// Throws GRBException if the environment fails to start, in which case it is tried again at the next call.
+    GRBEnv &getEnv(size_t thread_idx);
+
+  private:
+    std::vector<std::unique_ptr<GRBEnv>> envs_;
+};
+
+/// \brief A connected component of the vehicle-order graph, in which a vehicle and an order are linked if they appear
+/// in the same vehicle_trip_pair. Different components share no vehicles or orders, so they can be solved separately.
+struct AssignmentComponent {
+    std::vector<size_t> vehicle_ids;
+    std::vector<size_t> considered_order_indices;  // indices to considered_order_ids
+    std::vector<size_t> vehicle_trip_pair_indices;  // indices to vehicle_trip_pairs
+};
+
 /// \brief A function using an ILP solver (Gurobi) to compute the optimal assignment.
 /// It returns the indices of selected vehicle_trip_pairs, which maximize the overall score.
+/// \details The problem is first split into independent components. Components with a single vehicle are decided
+/// directly, and the others are solved as small ILP models concurrently, by the threads of solver_envs. If
+/// time_limit_ms > 0, the solver stops at it and returns the best solution found so far (falling back to greedy for the
+/// components without a solution). A component whose model fails is also assigned greedily.
+/// \param assignment_fell_back_to_greedy Set to true if any component is assigned greedily. The picking orders are then
+/// still kept with their vehicles where possible, but may be left out, so the caller has to repair the schedules.
 std::vector<size_t> IlpAssignment(const std::vector<SchedulingResult> &vehicle_trip_pairs,
                                   const std::vector<size_t> &considered_order_ids,
-                                  const std::vector<Order> &orders,
+                                  const OrderStore &orders,
                                   const std::vector<Vehicle> &vehicles,
-                                  bool ensure_assigning_orders_that_are_picking = true);
+                                  IlpSolverEnvs &solver_envs,
+                                  bool &assignment_fell_back_to_greedy,
+                                  bool ensure_assigning_orders_that_are_picking = true,
+                                  int32_t time_limit_ms = 0);
+
+/// \brief A function splitting the vehicle_trip_pairs into connected components (union-find on vehicles and orders).
+/// Vehicles without any pair and orders without any pair are not included in any component.
+std::vector<AssignmentComponent> ComputeConnectedComponentsOfVtPairs(
+        const std::vector<SchedulingResult> &vehicle_trip_pairs,
+        const std::vector<size_t> &considered_order_ids,
+        const std::vector<Vehicle> &vehicles);
+
+/// \brief A function deciding the assignment of a component having only one vehicle, without calling the solver.
+/// It returns the index of the pair with the highest score (serving all picking orders if required).
+size_t AssignSingleVehicleComponent(const AssignmentComponent &component,
+                                    const std::vector<SchedulingResult> &vehicle_trip_pairs,
+                                    const std::vector<size_t> &considered_order_ids,
+                                    const OrderStore &orders,
+                                    bool ensure_assigning_orders_that_are_picking);
 
 /// \brief A function greedily computes the assignment, in decreasing size of the trip and increasing cost.
 /// It returns the indices of selected vehicle_trip_pairs.
@@ -4,8 +4,58 @@
 
 #include "scheduling.hpp"
 
+#ifdef AMOD_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+#ifdef AMOD_X86_SIMD
+/// \brief The AVX2 kernel of FillQuickCheckBitmap(), comparing 8 vehicles at a time. The vehicles after the last
+/// full group of 8 are left to the caller.
+AMOD_TARGET_AVX2 void FillQuickCheckBitmapAvx2(const int32_t *travel_times_ms,
+                                               const int32_t *step_to_pos_durations_ms,
+                                               size_t num_of_vehicles,
+                                               int32_t max_time_ms,
+                                               uint64_t *bitmap) {
+    const auto max_times_ms = _mm256_set1_epi32(max_time_ms);
+    for (size_t i = 0; i + 8 <= num_of_vehicles; i += 8) {
+        auto times_ms = _mm256_add_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(travel_times_ms + i)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(step_to_pos_durations_ms + i)));
+        auto failed = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(times_ms, max_times_ms)));
+        bitmap[i / 64] |= static_cast<uint64_t>(~failed & 0xFF) << (i % 64);
+    }
+}
+#endif
+}  // namespace
+
+void FillQuickCheckBitmap(const std::vector<int32_t> &travel_times_ms,
+                          const std::vector<int32_t> &step_to_pos_durations_ms,
+                          int64_t max_time_ms,
+                          VehicleBitmap &bitmap) {
+    const auto num_of_vehicles = travel_times_ms.size();
+    assert(step_to_pos_durations_ms.size() == num_of_vehicles);
+    bitmap.assign((num_of_vehicles + 63) / 64, 0);
+    if (max_time_ms < 0) { return; }
+    const auto max_time_ms_int32 = static_cast<int32_t>(std::min<int64_t>(max_time_ms, INT32_MAX));
+
+    size_t i = 0;
+#ifdef AMOD_X86_SIMD
+    if (CpuSupportsAvx2()) {
+        FillQuickCheckBitmapAvx2(travel_times_ms.data(), step_to_pos_durations_ms.data(), num_of_vehicles,
+                                 max_time_ms_int32, bitmap.data());
+        i = num_of_vehicles / 8 * 8;
+    }
+#endif
+    for (; i < num_of_vehicles; i++) {
+        if (travel_times_ms[i] + step_to_pos_durations_ms[i] <= max_time_ms_int32) {
+            bitmap[i / 64] |= uint64_t{1} << (i % 64);
+        }
+    }
+}
+
 uint32_t ComputeScheduleCost(const std::vector<Waypoint> &schedule,
-                             const std::vector<Order> &orders,
+                             const OrderStore &orders,
                              const Vehicle &vehicle,
                              uint64_t system_time_ms) {
     if (schedule.empty()) { return 0; }
@@ -14,18 +64,19 @@ uint32_t ComputeScheduleCost(const std::vector<Waypoint> &schedule,
     auto cost_pickup_delay_ms = 0;
     auto cost_total_delay_ms = 0;
 
-    // Set the initial value of accumulated_time_ms as 0, when computing the cost of the vehicle's current working
-        // schedule. (Because when the schedule was updated to the vehicle, the vehicle's step_to_pos has been added to
-        // the build route. If "accumulated_time_ms = vehicle.step_to_pos.duration_ms", the vehicle's step_to_pos will
-        // be counted twice. The difference between a new generated schedule and a vehicle's working schedule is
-        // whether the vector term "steps" of route is empty.)
+    // Set the initial value of accumulated_time_ms as -vehicle.route_cursor.elapsed_ms, when computing the cost of the
+        // vehicle's current working schedule. (Because the built route of the first waypoint is kept complete while
+        // the vehicle moves on it, including the vehicle's step_to_pos which has been added to the route when the
+        // schedule was updated to the vehicle. The difference between a new generated schedule and a vehicle's
+        // working schedule is whether the vector term "steps" of route is empty.)
     auto &first_route = schedule[0].route;
-    if (!first_route.steps.empty() && accumulated_time_ms != 0) {
-        accumulated_time_ms = 0;
-        auto &first_step = first_route.steps[0];
-        assert(first_step.poses[0].node_id == vehicle.pos.node_id);
-        assert(first_step.poses[0].node_id == first_step.poses[1].node_id);
-        assert(first_step.duration_ms == vehicle.step_to_pos.duration_ms);
+    if (!first_route.steps.empty()) {
+        accumulated_time_ms = -vehicle.route_cursor.elapsed_ms;
+        assert(first_route.duration_ms + accumulated_time_ms >= 0);
+        assert(vehicle.step_to_pos.duration_ms == 0 ||
+               first_route.accumulated_duration_ms[vehicle.route_cursor.step_idx]
+               + first_route.steps[vehicle.route_cursor.step_idx].duration_ms
+               == vehicle.route_cursor.elapsed_ms + vehicle.step_to_pos.duration_ms);
     }
 
     for (const auto &wp : schedule) {
@@ -45,9 +96,10 @@ uint32_t ComputeScheduleCost(const std::vector<Waypoint> &schedule,
 }
 
 void ScoreVtPairsWithNumOfOrdersAndScheduleCost(std::vector<SchedulingResult> &vehicle_trip_pairs,
-                                                const std::vector<Order> &orders,
+                                                const OrderStore &orders,
                                                 const std::vector<Vehicle> &vehicles,
                                                 uint64_t system_time_ms) {
+    ScopedPhaseTimer t(ProfilerPhase::SCORING);
 
     // 1. Get the coefficients for NumOfOrders and ScheduleCost.
     int32_t max_schedule_cost = 1;
@@ -63,3 +115,8 @@ void ScoreVtPairsWithNumOfOrdersAndScheduleCost(std::vector<SchedulingResult> &v
         vt_pair.score = reward_for_serving_an_order * vt_pair.trip_ids.size() - vt_pair.best_schedule_cost_ms / 1e3;
     }
 }
+
+void CountVtPairsOfEachTripSize(const std::vector<SchedulingResult> &vehicle_trip_pairs) {
+    auto &dispatch_counters = Profiler::Global().getDispatchCounters();
+    for (const auto &vt_pair : vehicle_trip_pairs) { dispatch_counters.AddVtPairs(vt_pair.trip_ids.size()); }
+}
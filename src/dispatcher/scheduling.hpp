@@ -5,6 +5,7 @@
 #pragma once
 
 #include "utility/utility_functions.hpp"
+#include "simulator/vehicle.hpp"
 
 /// \brief The return type of the following function.
 /// \details If the order could not be inserted based on the current vehicle status, result is false.
@@ -29,7 +30,7 @@ struct SchedulingResult {
 /// \tparam router_func The router func that finds path between two poses.
 template <typename RouterFunc>
 SchedulingResult ComputeScheduleOfInsertingOrderToVehicle(const Order &order,
-                                                          const std::vector<Order> &orders,
+                                                          const OrderStore &orders,
                                                           const Vehicle &vehicle,
                                                           const std::vector<std::vector<Waypoint>> &sub_schedules,
                                                           uint64_t system_time_ms,
@@ -58,41 +59,77 @@ std::pair<bool, int> ValidateSchedule(const std::vector<Waypoint> &schedule,
                                       size_t pickup_idx,
                                       size_t dropoff_idx,
                                       const Order &order,
-                                      const std::vector<Order> &orders,
+                                      const OrderStore &orders,
                                       const Vehicle &vehicle,
                                       uint64_t system_time_ms,
                                       RouterFunc &router_func);
 
-/// \brief Quick check if a order is obviously cannot served by a vehicle.
+/// \brief The result of a fleet-wide filter, one bit per vehicle (indexed by vehicle id).
+using VehicleBitmap = std::vector<uint64_t>;
+
+/// \brief Return true if the vehicle's bit is set in the bitmap.
+inline bool VehicleBitmapHas(const VehicleBitmap &bitmap, size_t vehicle_id) {
+    return (bitmap[vehicle_id / 64] >> (vehicle_id % 64)) & 1;
+}
+
+/// \brief Set the bits of the vehicles (indexed by vehicle id) whose travel time to the order's origin plus their
+/// step_to_pos duration is within max_time_ms, and clear the others. The comparison is done with AVX2 if the CPU
+/// supports it.
+void FillQuickCheckBitmap(const std::vector<int32_t> &travel_times_ms,
+                          const std::vector<int32_t> &step_to_pos_durations_ms,
+                          int64_t max_time_ms,
+                          VehicleBitmap &bitmap);
+
+/// \brief Quick check which vehicles could serve the order, by scanning the fleet state. A vehicle fails the check
+/// if it obviously cannot serve the order, i.e. it cannot reach the order's origin in time even when it is idle.
 template <typename RouterFunc>
-bool PassQuickCheck(const Order &order, const Vehicle &vehicle, uint64_t system_time_ms, RouterFunc &router_func);
+VehicleBitmap QuickCheckOrderAgainstFleet(const Order &order,
+                                          const FleetState &fleet_state,
+                                          uint64_t system_time_ms,
+                                          RouterFunc &router_func);
+
+/// \brief Quick check each of the given orders against the whole fleet, returning one bitmap per order.
+template <typename RouterFunc>
+std::vector<VehicleBitmap> QuickCheckOrdersAgainstFleet(const std::vector<size_t> &order_ids,
+                                                        const OrderStore &orders,
+                                                        const FleetState &fleet_state,
+                                                        uint64_t system_time_ms,
+                                                        RouterFunc &router_func);
 
 /// \brief Build the detailed routes for all vehicles in the selected vehicle-trip pairs.
 template <typename RouterFunc>
 void UpdScheduleForVehiclesInSelectedVtPairs(std::vector<SchedulingResult> &vehicle_trip_pairs,
                                              const std::vector<size_t> &selected_vehicle_trip_pair_indices,
-                                             std::vector<Order> &orders,
+                                             OrderStore &orders,
                                              std::vector<Vehicle> &vehicles,
+                                             FleetState &fleet_state,
                                              RouterFunc &router_func);
 
-/// \brief Build the detailed route for a vehicle based on its assigned schedule, and update the vehicle's status.
+/// \brief Build the detailed route for a vehicle based on its assigned schedule, and update the vehicle's status
+/// (also in the fleet state).
 template <typename RouterFunc>
-void UpdVehicleScheduleAndBuildRoute(Vehicle &vehicle, std::vector<Waypoint> &schedule, RouterFunc &router_func);
+void UpdVehicleScheduleAndBuildRoute(Vehicle &vehicle,
+                                     FleetState &fleet_state,
+                                     std::vector<Waypoint> &schedule,
+                                     RouterFunc &router_func);
 
 /// \brief Compute the cost (time in millisecond) of serving the current schedule.
 /// \details The cost of serving the schedule is defined as the sum of each order's total travel delay.
 uint32_t ComputeScheduleCost(const std::vector<Waypoint> &schedule,
-                             const std::vector<Order> &orders,
+                             const OrderStore &orders,
                              const Vehicle &vehicle,
                              uint64_t system_time_ms);
 
 /// \brief Compute the scores of all candidate vehicle_trip_pairs.
 /// \details The score is defined as the reward of serving orders minus the schedule cost.
 void ScoreVtPairsWithNumOfOrdersAndScheduleCost(std::vector<SchedulingResult> &vehicle_trip_pairs,
-                                                const std::vector<Order> &orders,
+                                                const OrderStore &orders,
                                                 const std::vector<Vehicle> &vehicles,
                                                 uint64_t system_time_ms);
 
+/// \brief Count the vehicle_trip_pairs of each trip size in the profiler's dispatch counters.
+void CountVtPairsOfEachTripSize(const std::vector<SchedulingResult> &vehicle_trip_pairs);
+
 // Implementation is put in a separate file for clarity and maintainability.
 #include "scheduling_impl.hpp"
 
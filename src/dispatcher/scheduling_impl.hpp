@@ -14,7 +14,7 @@
 
 template<typename RouterFunc>
 SchedulingResult ComputeScheduleOfInsertingOrderToVehicle(const Order &order,
-                                                          const std::vector<Order> &orders,
+                                                          const OrderStore &orders,
                                                           const Vehicle &vehicle,
                                                           const std::vector<std::vector<Waypoint>> &sub_schedules,
                                                           uint64_t system_time_ms,
@@ -58,19 +58,21 @@ std::vector<Waypoint> GenerateScheduleFromSubSchedule(const Order &order,
                                                       RouterFunc &router_func) {
     std::vector<Waypoint> new_schedule;
     auto pre_pos = vehicle.pos;
+    const auto order_origin = router_func.getNodePos(order.origin_node_id);
+    const auto order_destination = router_func.getNodePos(order.destination_node_id);
     int idx = 0;
     while (true) {
         if (idx == pickup_idx) {
-            auto route = router_func(pre_pos, order.origin, RoutingType::TIME_ONLY);
+            auto route = router_func(pre_pos, order_origin, RoutingType::TIME_ONLY);
             new_schedule.emplace_back(
-                    Waypoint{order.origin, WaypointOp::PICKUP, order.id, std::move(route)});
-            pre_pos = order.origin;
+                    Waypoint{order_origin, WaypointOp::PICKUP, order.id, std::move(route)});
+            pre_pos = order_origin;
         }
         if (idx == dropoff_idx) {
-            auto route = router_func(pre_pos, order.destination, RoutingType::TIME_ONLY);
+            auto route = router_func(pre_pos, order_destination, RoutingType::TIME_ONLY);
             new_schedule.emplace_back(
-                    Waypoint{order.destination, WaypointOp::DROPOFF, order.id, std::move(route)});
-            pre_pos = order.destination;
+                    Waypoint{order_destination, WaypointOp::DROPOFF, order.id, std::move(route)});
+            pre_pos = order_destination;
         }
         if (idx >= sub_schedule.size()) {
             assert (!new_schedule.empty());
@@ -93,7 +95,7 @@ std::pair<bool, int> ValidateSchedule(const std::vector<Waypoint> &schedule,
                                       size_t pickup_idx,
                                       size_t dropoff_idx,
                                       const Order &order,
-                                      const std::vector<Order> &orders,
+                                      const OrderStore &orders,
                                       const Vehicle &vehicle,
                                       uint64_t system_time_ms,
                                       RouterFunc &router_func) {
@@ -144,23 +146,41 @@ std::pair<bool, int> ValidateSchedule(const std::vector<Waypoint> &schedule,
 }
 
 template <typename RouterFunc>
-bool PassQuickCheck(const Order &order, const Vehicle &vehicle, uint64_t system_time_ms, RouterFunc &router_func) {
-    // The vehicle can not serve the order even when it is idle.
-    if (router_func(vehicle.pos, order.origin, RoutingType::TIME_ONLY).duration_ms +
-        vehicle.step_to_pos.duration_ms + system_time_ms > order.max_pickup_time_ms) {
-        return false;
-    } else {
-        return true;
+VehicleBitmap QuickCheckOrderAgainstFleet(const Order &order,
+                                          const FleetState &fleet_state,
+                                          uint64_t system_time_ms,
+                                          RouterFunc &router_func) {
+    // The vehicle can not serve the order even when it is idle, if it cannot reach the origin by max_pickup_time_ms.
+    std::vector<int32_t> travel_times_ms;
+    router_func.getTravelTimesMsToNode(fleet_state.node_ids, order.origin_node_id, travel_times_ms);
+    VehicleBitmap bitmap;
+    FillQuickCheckBitmap(travel_times_ms, fleet_state.step_to_pos_durations_ms,
+                         static_cast<int64_t>(order.max_pickup_time_ms) - static_cast<int64_t>(system_time_ms), bitmap);
+    return bitmap;
+}
+
+template <typename RouterFunc>
+std::vector<VehicleBitmap> QuickCheckOrdersAgainstFleet(const std::vector<size_t> &order_ids,
+                                                        const OrderStore &orders,
+                                                        const FleetState &fleet_state,
+                                                        uint64_t system_time_ms,
+                                                        RouterFunc &router_func) {
+    std::vector<VehicleBitmap> bitmaps;
+    bitmaps.reserve(order_ids.size());
+    for (auto order_id : order_ids) {
+        bitmaps.push_back(QuickCheckOrderAgainstFleet(orders[order_id], fleet_state, system_time_ms, router_func));
     }
+    return bitmaps;
 }
 
 template <typename RouterFunc>
 void UpdScheduleForVehiclesInSelectedVtPairs(std::vector<SchedulingResult> &vehicle_trip_pairs,
                                              const std::vector<size_t> &selected_vehicle_trip_pair_indices,
-                                             std::vector<Order> &orders,
+                                             OrderStore &orders,
                                              std::vector<Vehicle> &vehicles,
+                                             FleetState &fleet_state,
                                              RouterFunc &router_func) {
-    TIMER_START(t)
+    ScopedPhaseTimer t(ProfilerPhase::ROUTE_BUILD);
     if (DEBUG_PRINT) {
         fmt::print("                *Executing assignment with {} pairs...",
                    selected_vehicle_trip_pair_indices.size());
@@ -171,7 +191,7 @@ void UpdScheduleForVehiclesInSelectedVtPairs(std::vector<SchedulingResult> &vehi
         for (auto order_id : vt_pair.trip_ids) { orders[order_id].status = OrderStatus::PICKING; }
         auto &vehicle = vehicles[vt_pair.vehicle_id];
         auto &schedule = vt_pair.feasible_schedules[vt_pair.best_schedule_idx];
-        UpdVehicleScheduleAndBuildRoute(vehicle, schedule, router_func);
+        UpdVehicleScheduleAndBuildRoute(vehicle, fleet_state, schedule, router_func);
 
 //        if (DEBUG_PRINT) {
 //            fmt::print("            +Assigned Trip #{} to Vehicle #{}, with a schedule has {} waypoints.\n",
@@ -184,7 +204,10 @@ void UpdScheduleForVehiclesInSelectedVtPairs(std::vector<SchedulingResult> &vehi
 
 
 template <typename RouterFunc>
-void UpdVehicleScheduleAndBuildRoute(Vehicle &vehicle, std::vector<Waypoint> &schedule, RouterFunc &router_func) {
+void UpdVehicleScheduleAndBuildRoute(Vehicle &vehicle,
+                                     FleetState &fleet_state,
+                                     std::vector<Waypoint> &schedule,
+                                     RouterFunc &router_func) {
     // If a rebalancing vehicle is assigned a trip while ensuring its visit to the reposition waypoint,
     // its rebalancing task can be cancelled.
     if (vehicle.status == VehicleStatus::REBALANCING && schedule.size() > 1) {
@@ -200,6 +223,7 @@ void UpdVehicleScheduleAndBuildRoute(Vehicle &vehicle, std::vector<Waypoint> &sc
 
     // 1. Update vehicle's schedule with detailed route.
     vehicle.schedule = schedule;
+    vehicle.route_cursor = RouteCursor();
     auto pre_pos = vehicle.pos;
     for (auto &wp : vehicle.schedule) {
         auto route = router_func(pre_pos, wp.pos, RoutingType::FULL_ROUTE);
@@ -220,12 +244,21 @@ void UpdVehicleScheduleAndBuildRoute(Vehicle &vehicle, std::vector<Waypoint> &sc
         }
     } else {
         vehicle.status = VehicleStatus::IDLE;
-        return;
     }
+    SyncFleetState(fleet_state, vehicle);
+    if (vehicle.schedule.empty()) { return; }
 
     // 3. Add vehicle's pre-route, when vehicle is currently on the road link instead of a waypoint node.
     if (vehicle.step_to_pos.duration_ms > 0) {
         auto &route = vehicle.schedule[0].route;
+        for (auto &accumulated_duration_ms : route.accumulated_duration_ms) {
+            accumulated_duration_ms += vehicle.step_to_pos.duration_ms;
+        }
+        for (auto &accumulated_distance_mm : route.accumulated_distance_mm) {
+            accumulated_distance_mm += vehicle.step_to_pos.distance_mm;
+        }
+        route.accumulated_duration_ms.insert(route.accumulated_duration_ms.begin(), 0);
+        route.accumulated_distance_mm.insert(route.accumulated_distance_mm.begin(), 0);
         route.duration_ms += vehicle.step_to_pos.duration_ms;
         route.distance_mm += vehicle.step_to_pos.distance_mm;
         route.steps.insert(route.steps.begin(), vehicle.step_to_pos);
@@ -43,20 +43,37 @@ int main(int argc, const char *argv[]) {
                   platform_config.data_file_path.path_to_vehicle_stations,
                   platform_config.data_file_path.path_to_shortest_path_table,
                   platform_config.data_file_path.path_to_mean_travel_time_table,
-                  platform_config.data_file_path.path_to_travel_distance_table};
+                  platform_config.data_file_path.path_to_travel_distance_table,
+                  platform_config.simulation_config.transposed_travel_time_table,
+                  platform_config.simulation_config.quantized_travel_tables};
 
-    // Create the demand generator based on the input demand file.
-    DemandGenerator demand_generator{platform_config.data_file_path.path_to_taxi_data,
-                                     platform_config.simulation_config.simulation_start_time,
-                                     platform_config.mod_system_config.request_config.request_density};
-
-    // Create the simulation platform with the config loaded from file.
-    Platform<decltype(router), decltype(demand_generator)> platform{std::move(platform_config),
-                                                                    std::move(router),
-                                                                    std::move(demand_generator)};
+    // Create the simulation platform with the config loaded from file and the demand generator, then run simulation.
+    auto run_simulation = [&](auto demand_generator) {
+        Platform<decltype(router), decltype(demand_generator)> platform{std::move(platform_config),
+                                                                        std::move(router),
+                                                                        std::move(demand_generator)};
+        platform.RunSimulation(getTimeStampMs(), (getTimeStampMs() - s_time_ms) / 1000.0);
+    };
 
-    // Run simulation.
-    platform.RunSimulation(getTimeStampMs(), (getTimeStampMs() - s_time_ms) / 1000.0);
+    // Create the demand generator based on the input demand file.
+    const auto &request_config = platform_config.mod_system_config.request_config;
+    if (request_config.demand_generator == "SYNTHETIC") {
+        run_simulation(SyntheticDemandGenerator{platform_config.data_file_path.path_to_taxi_data,
+                                                platform_config.simulation_config.simulation_start_time,
+                                                request_config.demand_scale,
+                                                request_config.random_seed});
+    } else {
+        // Upsampling the taxi data moves the cloned requests to the neighbouring nodes.
+        std::vector<std::vector<size_t>> neighbouring_nodes;
+        if (request_config.request_density > 1) {
+            neighbouring_nodes =
+                    router.getNeighbouringNodes(DemandGenerator::clone_max_travel_time_to_neighbouring_node_s);
+        }
+        run_simulation(DemandGenerator{platform_config.data_file_path.path_to_taxi_data,
+                                       platform_config.simulation_config.simulation_start_time,
+                                       request_config.request_density,
+                                       std::move(neighbouring_nodes)});
+    }
 
     return 0;
 }
@@ -10,12 +10,16 @@
 /// \brief Reposition the idel vehicles to the nearest pending orders, which have no vehicles around.
 /// \details Nearest Pending Order (NPO): dispatch idle vehicle to the locations of unassigned requests, under the
 /// assumption that it is likely that more requests occur in the same area where all requests cannot be satisfied
+/// \param active_order_ids A vector holding indices to the orders not yet complete or walkaway, in ascending order.
 /// \param orders A vector of all orders.
 /// \param vehicles A vector of all vehicles.
+/// \param fleet_state The fleet state, mirroring the vehicles' hot fields.
 /// \tparam router_func The router func that finds path between two poses.
 template <typename RouterFunc>
-void RepositionIdleVehiclesToNearestPendingOrders(const std::vector<Order> &orders,
+void RepositionIdleVehiclesToNearestPendingOrders(const std::vector<size_t> &active_order_ids,
+                                                const OrderStore &orders,
                                                 std::vector<Vehicle> &vehicles,
+                                                FleetState &fleet_state,
                                                 RouterFunc &router_func);
 
 // Implementation is put in a separate file for clarity and maintainability.
@@ -11,15 +11,17 @@
 #include <assert.h>
 
 template <typename RouterFunc>
-void RepositionIdleVehiclesToNearestPendingOrders(const std::vector<Order> &orders,
+void RepositionIdleVehiclesToNearestPendingOrders(const std::vector<size_t> &active_order_ids,
+                                                const OrderStore &orders,
                                                 std::vector<Vehicle> &vehicles,
+                                                FleetState &fleet_state,
                                                 RouterFunc &router_func) {
-    TIMER_START(t)
+    ScopedPhaseTimer t(ProfilerPhase::REBALANCE);
 
     // 1. Get a list of the unassigned orders.
     std::vector<size_t> pending_order_ids;
-    for (const auto &order : orders) {
-        if (order.status == OrderStatus::PENDING) { pending_order_ids.push_back(order.id); }
+    for (auto order_id : active_order_ids) {
+        if (orders[order_id].status == OrderStatus::PENDING) { pending_order_ids.push_back(order_id); }
     }
 
     if (DEBUG_PRINT) {
@@ -31,39 +33,57 @@ void RepositionIdleVehiclesToNearestPendingOrders(const std::vector<Order> &orde
                    num_of_idle_vehicles, pending_order_ids.size());
     }
 
-    // 2. Compute all rebalancing candidates.
-    std::vector<std::pair<size_t, std::vector<Waypoint>>> rebalancing_candidates;
+    // 2. Compute all rebalancing candidates, i.e. the travel time of each idle vehicle to each pending order.
+    //    The travel times to an order's origin are looked up for all idle vehicles in a batch.
+    std::vector<size_t> idle_vehicle_ids;
+    std::vector<uint32_t> idle_vehicle_node_ids;
     for (const auto &vehicle : vehicles) {
         if (vehicle.status != VehicleStatus::IDLE) { continue; }
-        for (auto order_id : pending_order_ids) {
-            auto rebalancing_route = router_func(vehicle.pos, orders[order_id].origin, RoutingType::TIME_ONLY);
-            std::vector<Waypoint> rebalancing_schedule =
-                    {Waypoint{orders[order_id].origin, WaypointOp::REPOSITION,
-                              orders[order_id].id, std::move(rebalancing_route)}};
-            rebalancing_candidates.push_back({vehicle.id, rebalancing_schedule});
+        idle_vehicle_ids.push_back(vehicle.id);
+        idle_vehicle_node_ids.push_back(vehicle.pos.node_id);
+    }
+    std::vector<std::vector<int32_t>> travel_times_ms_to_orders(pending_order_ids.size());
+    for (size_t j = 0; j < pending_order_ids.size(); j++) {
+        router_func.getTravelTimesMsToNode(idle_vehicle_node_ids, orders[pending_order_ids[j]].origin_node_id,
+                                           travel_times_ms_to_orders[j]);
+    }
+    struct RebalancingCandidate {
+        size_t vehicle_id;
+        size_t order_id;
+        int32_t duration_ms;
+    };
+    std::vector<RebalancingCandidate> rebalancing_candidates;
+    rebalancing_candidates.reserve(idle_vehicle_ids.size() * pending_order_ids.size());
+    for (size_t i = 0; i < idle_vehicle_ids.size(); i++) {
+        for (size_t j = 0; j < pending_order_ids.size(); j++) {
+            rebalancing_candidates.push_back({idle_vehicle_ids[i], pending_order_ids[j],
+                                              travel_times_ms_to_orders[j][i]});
         }
     }
 
     // 3. Select suitable rebalancing candidates. Greedily from the one with the shortest travel time.
     std::sort(rebalancing_candidates.begin(), rebalancing_candidates.end(),
-              [](std::pair<size_t, std::vector<Waypoint>> a, std::pair<size_t, std::vector<Waypoint>> b) {
-        return a.second[0].route.duration_ms < b.second[0].route.duration_ms;
+              [](const RebalancingCandidate &a, const RebalancingCandidate &b) {
+        return a.duration_ms < b.duration_ms;
     });
     std::vector<size_t> selected_vehicle_ids;
     std::vector<size_t> selected_order_ids;
-    for (auto &rebalancing_task : rebalancing_candidates) {
+    for (const auto &rebalancing_task : rebalancing_candidates) {
         // Check if the vehicle has been selected to do a rebalancing task.
-        if (std::find(selected_vehicle_ids.begin(), selected_vehicle_ids.end(), rebalancing_task.first)
+        if (std::find(selected_vehicle_ids.begin(), selected_vehicle_ids.end(), rebalancing_task.vehicle_id)
             != selected_vehicle_ids.end()) { continue; }
         // Check if the visiting point in the current rebalancing task has been visited.
-        if (std::find(selected_order_ids.begin(), selected_order_ids.end(), rebalancing_task.second[0].order_id)
+        if (std::find(selected_order_ids.begin(), selected_order_ids.end(), rebalancing_task.order_id)
             != selected_order_ids.end()) { continue; }
-        selected_vehicle_ids.push_back(rebalancing_task.first);
-        selected_order_ids.push_back(rebalancing_task.second[0].order_id);
-        // 4. Push the rebalancing task to the assigned vehicle.
-        auto &rebalancing_vehicle = vehicles[rebalancing_task.first];
-        auto &rebalancing_schedule = rebalancing_task.second;
-        UpdVehicleScheduleAndBuildRoute(rebalancing_vehicle, rebalancing_schedule, router_func);
+        selected_vehicle_ids.push_back(rebalancing_task.vehicle_id);
+        selected_order_ids.push_back(rebalancing_task.order_id);
+        // 4. Push the rebalancing task to the assigned vehicle. (The route is built by the update.)
+        auto &rebalancing_vehicle = vehicles[rebalancing_task.vehicle_id];
+        std::vector<Waypoint> rebalancing_schedule =
+                {Waypoint{router_func.getNodePos(orders[rebalancing_task.order_id].origin_node_id),
+                          WaypointOp::REPOSITION, rebalancing_task.order_id, Route{}}};
+        UpdVehicleScheduleAndBuildRoute(rebalancing_vehicle, fleet_state, rebalancing_schedule,
+                                        router_func);
 
 //        if (DEBUG_PRINT) {
 //            fmt::print("            +Reposition Vehicle #{} to Pos {}, where Order #{} is located.\n",
@@ -10,9 +10,12 @@
 /// \brief Reposition the idel vehicles randomly to vehicle stations.
 /// \details Random Vehicle Station (RVS): randomly dispatch idle vehicle to one of the vehicle stations.
 /// \param vehicles A vector of all vehicles.
+/// \param fleet_state The fleet state, mirroring the vehicles' hot fields.
 /// \tparam router_func The router func that finds path between two poses.
 template <typename RouterFunc>
-void RepositionIdleVehiclesToRandomVehicleStations(std::vector<Vehicle> &vehicles, RouterFunc &router_func);
+void RepositionIdleVehiclesToRandomVehicleStations(std::vector<Vehicle> &vehicles,
+                                                   FleetState &fleet_state,
+                                                   RouterFunc &router_func);
 
 // Implementation is put in a separate file for clarity and maintainability.
 #include "rebalancing_rvs_impl.hpp"
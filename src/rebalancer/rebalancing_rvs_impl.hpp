@@ -11,8 +11,10 @@
 #include <assert.h>
 
 template <typename RouterFunc>
-void RepositionIdleVehiclesToRandomVehicleStations(std::vector<Vehicle> &vehicles, RouterFunc &router_func) {
-    TIMER_START(t)
+void RepositionIdleVehiclesToRandomVehicleStations(std::vector<Vehicle> &vehicles,
+                                                   FleetState &fleet_state,
+                                                   RouterFunc &router_func) {
+    ScopedPhaseTimer t(ProfilerPhase::REBALANCE);
     int num_of_stations = router_func.getNumOfVehicleStations();
     if (DEBUG_PRINT) {
         int num_of_idle_vehicles = 0;
@@ -32,7 +34,8 @@ void RepositionIdleVehiclesToRandomVehicleStations(std::vector<Vehicle> &vehicle
         auto rebalancing_route = router_func(vehicle.pos, rebalancing_pos, RoutingType::TIME_ONLY);
         std::vector<Waypoint> rebalancing_schedule =
                 {Waypoint{rebalancing_pos, WaypointOp::REPOSITION, 0, std::move(rebalancing_route)}};
-        UpdVehicleScheduleAndBuildRoute(vehicle, rebalancing_schedule, router_func);
+        UpdVehicleScheduleAndBuildRoute(vehicle, fleet_state, rebalancing_schedule,
+                                        router_func);
         num_of_rebalancing_vehicles++;
     }
 
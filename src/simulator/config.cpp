@@ -2,8 +2,13 @@
 /// \date 2021/02/01
 
 #include "config.hpp"
+#include "utility/utility_functions.hpp"
 
 #include <fmt/format.h>
+
+#undef NDEBUG
+#include <assert.h>
+
 bool DEBUG_PRINT = false;
 
 PlatformConfig load_platform_config(const std::string &path_to_platform_config, const std::string &root_directory) {
@@ -23,9 +28,12 @@ PlatformConfig load_platform_config(const std::string &path_to_platform_config,
             root_directory + platform_config_yaml["data_file_path"]["mean_travel_time_table"].as<std::string>();
     platform_config.data_file_path.path_to_travel_distance_table =
             root_directory + platform_config_yaml["data_file_path"]["travel_distance_table"].as<std::string>();
+    platform_config.data_file_path.taxi_data_format =
+            platform_config_yaml["data_file_path"]["taxi_data_format"].as<std::string>();
     platform_config.data_file_path.path_to_taxi_data =
             root_directory + platform_config_yaml["data_file_path"]["taxi_data"].as<std::string>() +
-                    platform_config_yaml["data_file_path"]["data_file"].as<std::string>() + ".csv";
+                    platform_config_yaml["data_file_path"]["data_file"].as<std::string>() +
+                    (platform_config.data_file_path.taxi_data_format == "BINARY" ? ".bin" : ".csv");
     platform_config.data_file_path.taxi_data_file_name =
             platform_config_yaml["data_file_path"]["data_file"].as<std::string>();
 
@@ -42,6 +50,8 @@ PlatformConfig load_platform_config(const std::string &path_to_platform_config,
             platform_config_yaml["mod_system_config"]["dispatch_config"]["dispatcher"].as<std::string>();
     platform_config.mod_system_config.dispatch_config.rebalancer =
             platform_config_yaml["mod_system_config"]["dispatch_config"]["rebalancer"].as<std::string>();
+    platform_config.mod_system_config.dispatch_config.latency_budget_ms =
+            1000 * platform_config_yaml["mod_system_config"]["dispatch_config"]["latency_budget_s"].as<float>();
 
     platform_config.mod_system_config.fleet_config.fleet_size =
             platform_config_yaml["mod_system_config"]["fleet_config"]["fleet_size"].as<size_t>();
@@ -50,6 +60,12 @@ PlatformConfig load_platform_config(const std::string &path_to_platform_config,
 
     platform_config.mod_system_config.request_config.request_density =
             platform_config_yaml["mod_system_config"]["request_config"]["request_density"].as<float>();
+    platform_config.mod_system_config.request_config.demand_generator =
+            platform_config_yaml["mod_system_config"]["request_config"]["demand_generator"].as<std::string>();
+    platform_config.mod_system_config.request_config.demand_scale =
+            platform_config_yaml["mod_system_config"]["request_config"]["demand_scale"].as<float>();
+    platform_config.mod_system_config.request_config.random_seed =
+            platform_config_yaml["mod_system_config"]["request_config"]["random_seed"].as<uint64_t>();
     platform_config.mod_system_config.request_config.max_pickup_wait_time_s =
             60 * platform_config_yaml["mod_system_config"]["request_config"]["max_pickup_wait_time_min"].as<size_t>();
     platform_config.mod_system_config.request_config.max_onboard_detour =
@@ -65,11 +81,31 @@ PlatformConfig load_platform_config(const std::string &path_to_platform_config,
             platform_config_yaml["simulation_config"]["simulation_duration_min"].as<size_t>();
     platform_config.simulation_config.winddown_duration_min =
             platform_config_yaml["simulation_config"]["winddown_duration_min"].as<size_t>();
+    platform_config.simulation_config.num_of_threads =
+            platform_config_yaml["simulation_config"]["num_of_threads"].as<size_t>();
+    platform_config.simulation_config.event_driven =
+            platform_config_yaml["simulation_config"]["event_driven"].as<bool>();
+    platform_config.simulation_config.transposed_travel_time_table =
+            platform_config_yaml["simulation_config"]["transposed_travel_time_table"].as<bool>();
+    platform_config.simulation_config.quantized_travel_tables =
+            platform_config_yaml["simulation_config"]["quantized_travel_tables"].as<bool>();
+    auto path_to_order_archive = platform_config_yaml["simulation_config"]["order_archive"].as<std::string>();
+    if (!path_to_order_archive.empty()) {
+        platform_config.simulation_config.path_to_order_archive = root_directory + path_to_order_archive;
+    }
 
     platform_config.output_config.datalog_config.output_datalog =
             platform_config_yaml["output_config"]["datalog_config"]["output_datalog"].as<bool>();
     platform_config.output_config.datalog_config.path_to_output_datalog = root_directory +
             platform_config_yaml["output_config"]["datalog_config"]["path_to_output_datalog"].as<std::string>();
+    platform_config.output_config.datalog_config.datalog_format =
+            platform_config_yaml["output_config"]["datalog_config"]["datalog_format"].as<std::string>();
+    platform_config.output_config.datalog_config.datalog_compression =
+            platform_config_yaml["output_config"]["datalog_config"]["datalog_compression"].as<std::string>();
+    platform_config.output_config.datalog_config.keyframe_interval =
+            platform_config_yaml["output_config"]["datalog_config"]["keyframe_interval"].as<size_t>();
+    platform_config.output_config.datalog_config.write_in_background =
+            platform_config_yaml["output_config"]["datalog_config"]["write_in_background"].as<bool>();
     platform_config.output_config.video_config.render_video =
             platform_config_yaml["output_config"]["video_config"]["render_video"].as<bool>();
     platform_config.output_config.video_config.path_to_output_video = root_directory +
@@ -78,14 +114,44 @@ PlatformConfig load_platform_config(const std::string &path_to_platform_config,
             platform_config_yaml["output_config"]["video_config"]["frames_per_cycle"].as<size_t>();
     platform_config.output_config.video_config.replay_speed =
             platform_config_yaml["output_config"]["video_config"]["replay_speed"].as<size_t>();
+    auto path_to_output_profile =
+            platform_config_yaml["output_config"]["profile_config"]["path_to_output_profile"].as<std::string>();
+    if (!path_to_output_profile.empty()) {
+        platform_config.output_config.profile_config.path_to_output_profile = root_directory + path_to_output_profile;
+    }
+    platform_config.output_config.profile_config.profile_format =
+            platform_config_yaml["output_config"]["profile_config"]["profile_format"].as<std::string>();
+    auto path_to_output_epoch_metrics =
+            platform_config_yaml["output_config"]["profile_config"]["path_to_output_epoch_metrics"].as<std::string>();
+    if (!path_to_output_epoch_metrics.empty()) {
+        platform_config.output_config.profile_config.path_to_output_epoch_metrics =
+                root_directory + path_to_output_epoch_metrics;
+    }
 
     fmt::print("[INFO] Loaded the platform configuration yaml file from {}.\n",
                path_to_platform_config);
 
     // Sanity check of the input config.
+    assert((platform_config.data_file_path.taxi_data_format == "CSV" ||
+            platform_config.data_file_path.taxi_data_format == "BINARY") &&
+           "Config must have taxi_data_format of either CSV or BINARY!");
+    assert((platform_config.mod_system_config.request_config.demand_generator == "REPLAY" ||
+            platform_config.mod_system_config.request_config.demand_generator == "SYNTHETIC") &&
+           "Config must have demand_generator of either REPLAY or SYNTHETIC!");
+    assert(platform_config.mod_system_config.request_config.demand_scale > 0 &&
+           "Config must have positive demand_scale!");
+    assert(IsValidTimeDate(platform_config.simulation_config.simulation_start_time) &&
+           "Config must have simulation_start_time in \"%Y-%m-%d %H:%M:%S\"!");
+    assert(platform_config.simulation_config.num_of_threads > 0 &&
+           "Config must have positive num_of_threads!");
+    assert(platform_config.mod_system_config.dispatch_config.latency_budget_ms <=
+           platform_config.simulation_config.cycle_s * 1000 &&
+           "Config must have latency_budget_s no larger than cycle_s!");
     if (platform_config.output_config.datalog_config.output_datalog) {
         assert(platform_config.output_config.datalog_config.path_to_output_datalog != "" &&
                "Config must have non-empty path_to_output_datalog if output_datalog is true!");
+        assert(platform_config.output_config.datalog_config.keyframe_interval > 0 &&
+               "Config must have positive keyframe_interval if output_datalog is true!");
     }
     if (platform_config.output_config.video_config.render_video) {
         assert(platform_config.output_config.datalog_config.output_datalog &&
@@ -97,6 +163,9 @@ PlatformConfig load_platform_config(const std::string &path_to_platform_config,
         assert(platform_config.output_config.video_config.replay_speed > 0 &&
                "Config must have positive frames_per_cycle if render_video is true!");
     }
+    assert((platform_config.output_config.profile_config.profile_format == "CSV" ||
+            platform_config.output_config.profile_config.profile_format == "JSON") &&
+           "Config must have profile_format of either CSV or JSON!");
 
     return platform_config;
 }
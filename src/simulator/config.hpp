@@ -16,6 +16,7 @@ struct DataFilePath {
     std::string path_to_mean_travel_time_table = "";
     std::string path_to_travel_distance_table = "";
     std::string path_to_taxi_data = "";
+    std::string taxi_data_format = "CSV";  // "CSV", or "BINARY" for the converted binary demand file (.bin)
     std::string taxi_data_file_name = "";
 };
 
@@ -31,6 +32,7 @@ struct AreaConfig {
 struct DispatchConfig {
     std::string dispatcher = "GI";       // the method used to assign orders to vehicles
     std::string rebalancer = "NONE";     // the method used to reposition idle vehicles ahead of time
+    size_t latency_budget_ms = 0;        // the max computational time of OSP at each epoch, 0 = no limit
 };
 
 /// \brief Config that describes the fleet.
@@ -41,7 +43,10 @@ struct FleetConfig {
 
 /// \brief Config that describes the requests.
 struct RequestConfig {
-    float request_density = 1.0; // the percentage of taxi data considered
+    float request_density = 1.0; // the percentage of taxi data considered, > 1 clones the requests (upsampling)
+    std::string demand_generator = "REPLAY"; // "REPLAY" the taxi data, or "SYNTHETIC" requests fitted to it
+    float demand_scale = 1.0;    // SYNTHETIC only: the demand volume as a multiple of the taxi data, any positive value
+    uint64_t random_seed = 0;    // SYNTHETIC only: the seed of the sampled requests
     size_t max_pickup_wait_time_s = 300; // the max wait time allowed between a request is generated
                                          // and the request is picked up
     float max_onboard_detour = 1.3;      // the max detour raised by ride-sharing when the request in onboard
@@ -62,12 +67,21 @@ struct SimulationConfig {
     size_t simulation_duration_min =
             120; // the main period during which the simulated data is used for analysis
     size_t winddown_duration_min = 39; // the period after the main sim to close trips
+    size_t num_of_threads = 1;         // the number of threads advancing vehicles and solving the ILP, 1 = serial
+    bool event_driven = false;         // true if vehicles are advanced by their own events instead of every frame
+    std::string path_to_order_archive = ""; // the file the complete/walkaway orders are spilled to, empty = in memory
+    bool transposed_travel_time_table = false; // true if the router also holds the travel time table transposed
+    bool quantized_travel_tables = false;      // true if the router's travel time/distance tables are stored in uint16
 };
 
 /// \brief Config for the output datalog.
 struct DatalogConfig {
     bool output_datalog = false;             // true if we output datalog
     std::string path_to_output_datalog = ""; // the path to the output datalog, empty if no output
+    std::string datalog_format = "YAML";     // the format of the output datalog, "YAML" or "BINARY"
+    std::string datalog_compression = "NONE"; // the compression of the output datalog, "NONE", "GZIP" or "ZSTD"
+    size_t keyframe_interval = 1;            // binary only: a full frame every x frames, only changes in between
+    bool write_in_background = false;        // true if the datalog is written by a background thread
 };
 
 /// \brief Config for video rendering.
@@ -78,10 +92,18 @@ struct VideoConfig {
     size_t replay_speed = 200;  // the speed of the video replay as compared to the actual system time
 };
 
-/// \brief Config that describes the output modes for datalog and video.
+/// \brief Config for the export of the per-phase latency profile and the per-epoch metrics.
+struct ProfileConfig {
+    std::string path_to_output_profile = ""; // the path to the exported profile, empty if no export
+    std::string profile_format = "CSV";      // the format of the exported profile, "CSV" or "JSON"
+    std::string path_to_output_epoch_metrics = ""; // the path to the csv of per-epoch metrics, empty if no output
+};
+
+/// \brief Config that describes the output modes for datalog, video and profile.
 struct OutputConfig {
     DatalogConfig datalog_config;
     VideoConfig video_config;
+    ProfileConfig profile_config;
 };
 
 /// \brief The set of config parameters for the simulation platform.
@@ -0,0 +1,280 @@
+#include "datalog.hpp"
+
+#include <yaml-cpp/yaml.h>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+
+DatalogFrameBuilder::DatalogFrameBuilder(size_t _keyframe_interval) : keyframe_interval_(_keyframe_interval) {
+    assert(keyframe_interval_ > 0 && "The keyframe interval of the datalog must be positive!");
+}
+
+void DatalogFrameBuilder::Build(DatalogFrame &frame,
+                                uint64_t system_time_ms,
+                                const std::vector<Vehicle> &vehicles,
+                                const OrderStore &orders,
+                                const std::vector<Pos> &network_nodes,
+                                bool schedules_may_have_been_rebuilt) {
+    frame.system_time_ms = system_time_ms;
+    frame.is_keyframe = num_of_frames_built_ % keyframe_interval_ == 0;
+    frame.vehicles.clear();
+    frame.waypoint_sizes.clear();
+    frame.points.clear();
+    frame.orders.clear();
+    num_of_frames_built_++;
+
+    last_vehicle_records_.resize(vehicles.size());
+    last_schedule_sizes_.resize(vehicles.size(), 0);
+    for (const auto &vehicle : vehicles) {
+        DatalogVehicleRecord record;
+        record.id = static_cast<uint32_t>(vehicle.id);
+        record.lon = vehicle.pos.lon;
+        record.lat = vehicle.pos.lat;
+        record.step_idx = static_cast<uint32_t>(vehicle.route_cursor.step_idx);
+        const auto schedule_size = static_cast<uint32_t>(vehicle.schedule.size());
+        auto &last_record = last_vehicle_records_[vehicle.id];
+        auto &last_schedule_size = last_schedule_sizes_[vehicle.id];
+
+        // Between two frames, the schedule either is rebuilt, or only has its first waypoints reached.
+        if (frame.is_keyframe || (schedules_may_have_been_rebuilt &&
+                                  vehicle.schedule_has_been_updated_at_current_epoch)) {
+            record.num_of_waypoints = schedule_size;
+        } else {
+            assert(schedule_size <= last_schedule_size && "Vehicle's schedule has grown without being rebuilt!");
+            record.num_of_waypoints_reached = last_schedule_size - schedule_size;
+            if (record.num_of_waypoints_reached == 0 && record.step_idx == last_record.step_idx &&
+                record.lon == last_record.lon && record.lat == last_record.lat) {
+                continue;
+            }
+        }
+        last_record = record;
+        last_schedule_size = schedule_size;
+        frame.vehicles.push_back(record);
+
+        if (record.num_of_waypoints == datalog_schedule_unchanged) { continue; }
+        for (const auto &waypoint : vehicle.schedule) {
+            for (const auto &step : waypoint.route.steps) {
+                frame.points.push_back({step.poses[0].lon, step.poses[0].lat});
+                frame.points.push_back({step.poses[1].lon, step.poses[1].lat});
+            }
+            frame.waypoint_sizes.push_back(static_cast<uint32_t>(waypoint.route.steps.size() * 2));
+        }
+    }
+
+    // An order only changes its status (and the pickup/dropoff time along with it) after being created. The archived
+    // orders were written with their final status before being archived, so no frame looks at them again (which
+    // would read a spilled archive back from its file), and their statuses are dropped.
+    const auto first_hot_order_id = orders.GetFirstHotOrderId();
+    const auto num_of_archived_statuses =
+            std::min(first_hot_order_id - first_tracked_order_id_, last_order_statuses_.size());
+    last_order_statuses_.erase(last_order_statuses_.begin(), last_order_statuses_.begin() + num_of_archived_statuses);
+    first_tracked_order_id_ = first_hot_order_id;
+    const auto num_of_orders_at_last_frame = first_tracked_order_id_ + last_order_statuses_.size();
+    last_order_statuses_.resize(orders.size() - first_tracked_order_id_);
+    orders.ForEachOrder([&](const Order &order) {
+        auto &last_order_status = last_order_statuses_[order.id - first_tracked_order_id_];
+        if (!frame.is_keyframe && order.id < num_of_orders_at_last_frame && order.status == last_order_status) {
+            return;
+        }
+        last_order_status = order.status;
+
+        DatalogOrderRecord record;
+        record.id = static_cast<uint32_t>(order.id);
+        record.status = static_cast<uint32_t>(order.status);
+        const auto &origin = network_nodes[order.origin_node_id - 1];
+        const auto &destination = network_nodes[order.destination_node_id - 1];
+        record.origin_lon = origin.lon;
+        record.origin_lat = origin.lat;
+        record.destination_lon = destination.lon;
+        record.destination_lat = destination.lat;
+        record.request_time_ms = order.request_time_ms;
+        record.max_pickup_time_ms = order.max_pickup_time_ms;
+        record.pickup_time_ms = order.pickup_time_ms;
+        record.dropoff_time_ms = order.dropoff_time_ms;
+        frame.orders.push_back(record);
+    }, first_hot_order_id);
+}
+
+DatalogWriter::~DatalogWriter() {
+    Close();
+}
+
+void DatalogWriter::Open(const std::string &path_to_datalog,
+                         DatalogFormat format,
+                         DatalogCompression compression,
+                         size_t keyframe_interval,
+                         bool write_in_background) {
+    format_ = format;
+    if (format_ == DatalogFormat::BINARY || compression != DatalogCompression::NONE) {
+        datalog_file_.open(path_to_datalog, std::ios::out | std::ios::binary);
+    } else {
+        datalog_file_.open(path_to_datalog);
+    }
+    assert(datalog_file_.is_open() && "Failed to open the output datalog file!");
+
+    // Level 1 compression is used, as the datalog is written during the simulation.
+    if (compression == DatalogCompression::GZIP) {
+        datalog_ostream_.push(boost::iostreams::gzip_compressor(boost::iostreams::gzip_params(1)));
+    } else if (compression == DatalogCompression::ZSTD) {
+        datalog_ostream_.push(boost::iostreams::zstd_compressor(boost::iostreams::zstd_params(1)));
+    }
+    datalog_ostream_.push(datalog_file_);
+
+    if (format_ == DatalogFormat::BINARY) {
+        DatalogFileHeader file_header;
+        file_header.keyframe_interval = static_cast<uint32_t>(keyframe_interval);
+        datalog_ostream_.write(reinterpret_cast<const char *>(&file_header), sizeof(file_header));
+    }
+
+    if (write_in_background) {
+        writer_thread_should_stop_ = false;
+        writer_thread_ = std::thread(&DatalogWriter::RunWriterThread, this);
+    }
+}
+
+void DatalogWriter::Close() {
+    if (writer_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            writer_thread_should_stop_ = true;
+        }
+        frame_pending_cv_.notify_one();
+        writer_thread_.join();
+    }
+    if (datalog_file_.is_open()) {
+        // Resetting the stream flushes the compressor, which writes the end of the compressed stream to the file.
+        datalog_ostream_.reset();
+        datalog_file_.close();
+    }
+}
+
+void DatalogWriter::WriteFrame(DatalogFrame &frame) {
+    if (!writer_thread_.joinable()) {
+        WriteFrameToFile(frame);
+        return;
+    }
+
+    // Wait for a free buffer (back-pressure), then swap the frame into the pending queue.
+    std::unique_lock<std::mutex> lock(mutex_);
+    frame_written_cv_.wait(lock, [this] { return pending_frames_.size() < max_num_of_pending_frames_; });
+    if (written_frames_.empty()) {
+        pending_frames_.emplace_back();
+    } else {
+        pending_frames_.push_back(std::move(written_frames_.back()));
+        written_frames_.pop_back();
+    }
+    std::swap(pending_frames_.back(), frame);
+    lock.unlock();
+    frame_pending_cv_.notify_one();
+}
+
+void DatalogWriter::RunWriterThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        frame_pending_cv_.wait(lock, [this] { return !pending_frames_.empty() || writer_thread_should_stop_; });
+        if (pending_frames_.empty()) { return; }
+
+        // The front frame stays in the queue while being written, so that it still counts as pending.
+        // (Its reference remains valid, as the simulation thread only pushes to the back of the deque.)
+        const auto &frame = pending_frames_.front();
+        lock.unlock();
+        WriteFrameToFile(frame);
+        lock.lock();
+
+        written_frames_.push_back(std::move(pending_frames_.front()));
+        pending_frames_.pop_front();
+        frame_written_cv_.notify_one();
+    }
+}
+
+void DatalogWriter::WriteFrameToFile(const DatalogFrame &frame) {
+    if (format_ == DatalogFormat::BINARY) {
+        WriteFrameInBinary(frame);
+    } else {
+        WriteFrameInYaml(frame);
+    }
+}
+
+void DatalogWriter::WriteFrameInYaml(const DatalogFrame &frame) {
+    assert(frame.is_keyframe && "Only keyframes can be written to the datalog in yaml!");
+    YAML::Node node;
+    node["system_time_ms"] = frame.system_time_ms;
+
+    // For each of the vehicles, we write the relevant data in yaml format.
+    auto waypoint_idx = 0;
+    auto point_idx = 0;
+    for (const auto &vehicle : frame.vehicles) {
+        YAML::Node veh_node;
+
+        YAML::Node pos_node;
+        pos_node["lon"] = fmt::format("{:.6f}", vehicle.lon);
+        pos_node["lat"] = fmt::format("{:.6f}", vehicle.lat);
+        veh_node["pos"] = std::move(pos_node);
+
+        YAML::Node waypoints_node;
+        for (auto i = 0; i < vehicle.num_of_waypoints; i++) {
+            YAML::Node waypoint_node;
+            // The route of the first waypoint is written from the vehicle's current position.
+            auto first_point_idx = i == 0 ? vehicle.step_idx * 2 : 0;
+            for (auto j = first_point_idx; j < frame.waypoint_sizes[waypoint_idx]; j++) {
+                const auto &point = frame.points[point_idx + j];
+                YAML::Node step_node;
+                step_node["lon"] = fmt::format("{:.6f}", j == first_point_idx && i == 0 ? vehicle.lon : point.lon);
+                step_node["lat"] = fmt::format("{:.6f}", j == first_point_idx && i == 0 ? vehicle.lat : point.lat);
+                waypoint_node.push_back(std::move(step_node));
+            }
+            waypoints_node.push_back(std::move(waypoint_node));
+            point_idx += frame.waypoint_sizes[waypoint_idx];
+            waypoint_idx++;
+        }
+        veh_node["waypoints"] = std::move(waypoints_node);
+        node["vehicles"].push_back(std::move(veh_node));
+    }
+
+    // For each of the orders, we write the relevant data in yaml format.
+    for (const auto &order : frame.orders) {
+        YAML::Node origin_pos_node;
+        origin_pos_node["lon"] = fmt::format("{:.6f}", order.origin_lon);
+        origin_pos_node["lat"] = fmt::format("{:.6f}", order.origin_lat);
+
+        YAML::Node destination_pos_node;
+        destination_pos_node["lon"] = fmt::format("{:.6f}", order.destination_lon);
+        destination_pos_node["lat"] = fmt::format("{:.6f}", order.destination_lat);
+
+        YAML::Node order_node;
+        order_node["id"] = order.id;
+        order_node["origin"] = std::move(origin_pos_node);
+        order_node["destination"] = std::move(destination_pos_node);
+        order_node["status"] = order_status_to_string(static_cast<OrderStatus>(order.status));
+        order_node["request_time_ms"] = order.request_time_ms;
+        order_node["max_pickup_time_ms"] = order.max_pickup_time_ms;
+        order_node["pickup_time_ms"] = order.pickup_time_ms;
+        order_node["dropoff_time_ms"] = order.dropoff_time_ms;
+
+        node["orders"].push_back(std::move(order_node));
+    }
+
+    // The document is emitted to memory first, as the stream may go through a compressor.
+    YAML::Emitter emitter;
+    emitter << node;
+    datalog_ostream_ << emitter.c_str() << "\n---\n";
+}
+
+void DatalogWriter::WriteFrameInBinary(const DatalogFrame &frame) {
+    DatalogFrameHeader frame_header;
+    frame_header.system_time_ms = frame.system_time_ms;
+    frame_header.is_keyframe = frame.is_keyframe;
+    frame_header.num_of_vehicles = static_cast<uint32_t>(frame.vehicles.size());
+    frame_header.num_of_waypoints = static_cast<uint32_t>(frame.waypoint_sizes.size());
+    frame_header.num_of_points = static_cast<uint32_t>(frame.points.size());
+    frame_header.num_of_orders = static_cast<uint32_t>(frame.orders.size());
+
+    datalog_ostream_.write(reinterpret_cast<const char *>(&frame_header), sizeof(frame_header));
+    datalog_ostream_.write(reinterpret_cast<const char *>(frame.vehicles.data()),
+                            frame.vehicles.size() * sizeof(DatalogVehicleRecord));
+    datalog_ostream_.write(reinterpret_cast<const char *>(frame.waypoint_sizes.data()),
+                            frame.waypoint_sizes.size() * sizeof(uint32_t));
+    datalog_ostream_.write(reinterpret_cast<const char *>(frame.points.data()),
+                            frame.points.size() * sizeof(DatalogPoint));
+    datalog_ostream_.write(reinterpret_cast<const char *>(frame.orders.data()),
+                            frame.orders.size() * sizeof(DatalogOrderRecord));
+}
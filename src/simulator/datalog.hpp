@@ -0,0 +1,229 @@
+#pragma once
+
+#include "types.hpp"
+#include "order_store.hpp"
+
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <fstream>
+#include <cstdint>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#undef NDEBUG
+#include <assert.h>
+
+/// \brief The format of the output datalog.
+enum class DatalogFormat {
+    YAML,    // one yaml document per frame, human readable but slow to write and large on disk
+    BINARY   // fixed-size little-endian records per frame, read back by python/datalog_reader.py
+};
+
+/// \brief The compression of the output datalog, applied to the whole file as a stream.
+enum class DatalogCompression {
+    NONE,    // no compression
+    GZIP,    // gzip (zlib level 1), readable by any gzip tool
+    ZSTD     // zstd (level 1), faster and smaller than gzip
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/// Binary Datalog Records
+/// A binary datalog starts with a DatalogFileHeader, followed by the frames. Each frame consists of
+/// a DatalogFrameHeader, num_of_vehicles DatalogVehicleRecord, num_of_waypoints uint32_t (the number of points of
+/// each waypoint route, in the order of vehicles and then waypoints), num_of_points DatalogPoint and
+/// num_of_orders DatalogOrderRecord.
+/// A keyframe holds all vehicles (with their full schedules) and all orders. A delta frame only holds the vehicles
+/// that have moved or have a changed schedule, and the orders that are new or have a changed status. The routes are
+/// always the full routes of the waypoints, and the part already traveled is given by the route cursor's step_idx.
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \brief The header at the start of the binary datalog file.
+struct DatalogFileHeader {
+    char magic[8] = {'A', 'M', 'o', 'D', '2', 'L', 'O', 'G'};
+    uint32_t version = 2;
+    uint32_t keyframe_interval = 1;
+};
+
+/// \brief The header of a frame, giving the number of records that follow.
+struct DatalogFrameHeader {
+    uint64_t system_time_ms = 0;
+    uint32_t is_keyframe = 1;
+    uint32_t num_of_vehicles = 0;
+    uint32_t num_of_waypoints = 0;
+    uint32_t num_of_points = 0;
+    uint32_t num_of_orders = 0;
+    uint32_t reserved = 0;
+};
+
+/// \brief A position (lon/lat) on a vehicle's route.
+struct DatalogPoint {
+    float lon = 0.0;
+    float lat = 0.0;
+};
+
+/// \brief The num_of_waypoints of a vehicle record whose schedule is not written, as it has not been rebuilt.
+constexpr uint32_t datalog_schedule_unchanged = UINT32_MAX;
+
+/// \brief The vehicle's position, its progress on the route and the number of waypoints in its schedule.
+/// \details If the schedule is unchanged, the first num_of_waypoints_reached waypoints of the last written schedule
+/// are removed. Otherwise, the new schedule has num_of_waypoints waypoints, whose routes follow in the frame.
+struct DatalogVehicleRecord {
+    uint32_t id = 0;
+    float lon = 0.0;
+    float lat = 0.0;
+    uint32_t step_idx = 0;                  // the route cursor's step on the route of the first waypoint
+    uint32_t num_of_waypoints_reached = 0;  // the waypoints reached since the last frame (unchanged schedule only)
+    uint32_t num_of_waypoints = datalog_schedule_unchanged;
+};
+
+/// \brief The order's positions, status and times.
+struct DatalogOrderRecord {
+    uint32_t id = 0;
+    uint32_t status = 0;  // the OrderStatus value
+    float origin_lon = 0.0;
+    float origin_lat = 0.0;
+    float destination_lon = 0.0;
+    float destination_lat = 0.0;
+    int32_t request_time_ms = 0;
+    int32_t max_pickup_time_ms = 0;
+    int32_t pickup_time_ms = 0;
+    int32_t dropoff_time_ms = 0;
+};
+
+static_assert(sizeof(DatalogFileHeader) == 16, "Unexpected padding in DatalogFileHeader!");
+static_assert(sizeof(DatalogFrameHeader) == 32, "Unexpected padding in DatalogFrameHeader!");
+static_assert(sizeof(DatalogPoint) == 8, "Unexpected padding in DatalogPoint!");
+static_assert(sizeof(DatalogVehicleRecord) == 24, "Unexpected padding in DatalogVehicleRecord!");
+static_assert(sizeof(DatalogOrderRecord) == 40, "Unexpected padding in DatalogOrderRecord!");
+
+/// \brief The snapshot of the simulation state at one frame, made of flat records that can be written as they are.
+struct DatalogFrame {
+    uint64_t system_time_ms = 0;
+    bool is_keyframe = true;
+    std::vector<DatalogVehicleRecord> vehicles;
+    std::vector<uint32_t> waypoint_sizes;  // the number of points of each written waypoint route
+    std::vector<DatalogPoint> points;
+    std::vector<DatalogOrderRecord> orders;
+};
+
+/// \brief The builder that takes the snapshots of the vehicles and orders, as keyframes or delta frames.
+class DatalogFrameBuilder {
+  public:
+    /// \brief Constructor. A keyframe is built every keyframe_interval frames (1 = every frame is a keyframe).
+    explicit DatalogFrameBuilder(size_t _keyframe_interval = 1);
+
+    /// \brief Take the snapshot of the vehicles and orders at the current system time. Only the hot orders are
+    /// written, as an archived order was already complete or walkaway at the last frame (if any) and never changes.
+    /// \param network_nodes the poses of the nodes (node_id - 1 indexed), giving the orders' origins and destinations.
+    /// \param schedules_may_have_been_rebuilt true if the dispatcher or the rebalancer has run since the last frame,
+    /// in which case the vehicles with schedule_has_been_updated_at_current_epoch have their schedules rewritten.
+    void Build(DatalogFrame &frame,
+               uint64_t system_time_ms,
+               const std::vector<Vehicle> &vehicles,
+               const OrderStore &orders,
+               const std::vector<Pos> &network_nodes,
+               bool schedules_may_have_been_rebuilt);
+
+  private:
+    /// \brief The number of frames between two keyframes.
+    size_t keyframe_interval_ = 1;
+
+    /// \brief The number of frames that have been built.
+    size_t num_of_frames_built_ = 0;
+
+    /// \brief The vehicle records at the last frame, to find the vehicles that have changed.
+    std::vector<DatalogVehicleRecord> last_vehicle_records_;
+
+    /// \brief The schedule size of each vehicle at the last frame, to find the waypoints reached since then.
+    std::vector<uint32_t> last_schedule_sizes_;
+
+    /// \brief The status of each hot order at the last frame, to find the orders that have changed. The order with id
+    /// first_tracked_order_id_ first, the statuses of the archived orders are dropped.
+    std::deque<OrderStatus> last_order_statuses_;
+
+    /// \brief The id of the order whose status is at the front of last_order_statuses_.
+    size_t first_tracked_order_id_ = 0;
+};
+
+/// \brief The writer that outputs the datalog frames to file, in yaml or binary format.
+/// \details In the background mode, the frames are handed over to a writer thread through a bounded queue of
+/// max_num_of_pending_frames buffers, so that the serialization and the file I/O overlap with the simulation.
+/// The simulation thread only waits when all the buffers are pending.
+class DatalogWriter {
+  public:
+    /// \brief Constructor.
+    DatalogWriter() = default;
+
+    /// \brief Destructor. Close the file after the pending frames are written.
+    ~DatalogWriter();
+
+    /// \brief Delete the other constructors. Rule of five.
+    DatalogWriter(const DatalogWriter &other) = delete;
+    DatalogWriter(DatalogWriter &&other) = delete;
+    DatalogWriter &operator=(const DatalogWriter &other) = delete;
+    DatalogWriter &operator=(DatalogWriter &&other) = delete;
+
+    /// \brief Open the file and write the file header (binary format only).
+    /// \param write_in_background true if the frames are written by a background thread.
+    void Open(const std::string &path_to_datalog,
+              DatalogFormat format,
+              DatalogCompression compression = DatalogCompression::NONE,
+              size_t keyframe_interval = 1,
+              bool write_in_background = false);
+
+    /// \brief Write the pending frames and close the file.
+    void Close();
+
+    /// \brief Return true if the file is open.
+    bool IsOpen() const { return datalog_file_.is_open(); }
+
+    /// \brief Write a frame to file. In the background mode, the frame's buffers are taken over by the writer and
+    /// the frame is given the buffers of an already written frame in return (to be cleared by the next Build()).
+    void WriteFrame(DatalogFrame &frame);
+
+  private:
+    /// \brief Write the frame to file, in the format of the writer.
+    void WriteFrameToFile(const DatalogFrame &frame);
+
+    /// \brief Write a frame as a yaml document. Only keyframes can be written in yaml.
+    void WriteFrameInYaml(const DatalogFrame &frame);
+
+    /// \brief Write a frame as binary records.
+    void WriteFrameInBinary(const DatalogFrame &frame);
+
+    /// \brief The loop of the background writer thread.
+    void RunWriterThread();
+
+    /// \brief The format of the output.
+    DatalogFormat format_ = DatalogFormat::YAML;
+
+    /// \brief The datalog file.
+    std::ofstream datalog_file_;
+
+    /// \brief The stream that outputs to the datalog file, through the compressor if any.
+    boost::iostreams::filtering_ostream datalog_ostream_;
+
+    /// \brief The max number of frames handed over to the writer thread and not yet written (double buffering).
+    static constexpr size_t max_num_of_pending_frames_ = 2;
+
+    /// \brief The background writer thread, not joinable if the frames are written by the simulation thread.
+    std::thread writer_thread_;
+
+    /// \brief The frames waiting to be written, the earliest first.
+    std::deque<DatalogFrame> pending_frames_;
+
+    /// \brief The frames that have been written, whose buffers are reused for the next frames.
+    std::vector<DatalogFrame> written_frames_;
+
+    /// \brief True if the writer thread should exit once the pending frames are written.
+    bool writer_thread_should_stop_ = false;
+
+    /// \brief The mutex guarding pending_frames_, written_frames_ and writer_thread_should_stop_.
+    std::mutex mutex_;
+
+    /// \brief Notified when a frame is pending (to the writer) or a frame has been written (to the simulation).
+    std::condition_variable frame_pending_cv_;
+    std::condition_variable frame_written_cv_;
+};
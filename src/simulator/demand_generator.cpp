@@ -3,24 +3,102 @@
 
 #include "demand_generator.hpp"
 
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <cmath>
 #include <fmt/format.h>
 #undef NDEBUG
 #include <assert.h>
 
+namespace {
+/// \brief The splitmix64 finalizer, mixing all bits of the value into all bits of the hash.
+uint64_t SplitMix64(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+/// \brief A function mapping the taxi trip data from a binary demand file into memory.
+/// It returns the records and their number, and sets the base date of the file.
+std::pair<std::shared_ptr<const DemandRecord>, size_t> MapRequestsFromBinaryFile(std::string path_to_bin,
+                                                                               std::string &base_date) {
+    CheckFileExistence(path_to_bin);
+    auto fd = open(path_to_bin.c_str(), O_RDONLY);
+    assert(fd >= 0 && "[ERROR] Failed to open the binary demand file!");
+    struct stat file_stat;
+    fstat(fd, &file_stat);
+    auto file_size = static_cast<size_t>(file_stat.st_size);
+    assert(file_size >= sizeof(DemandFileHeader) && "[ERROR] The binary demand file is truncated!");
+    auto mapped_address = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    assert(mapped_address != MAP_FAILED && "[ERROR] Failed to map the binary demand file!");
+    // The records are read forward as the simulation goes on (after a binary search for the start).
+    madvise(mapped_address, file_size, MADV_SEQUENTIAL);
+
+    const auto *header = static_cast<const DemandFileHeader *>(mapped_address);
+    DemandFileHeader expected_header;
+    assert(std::equal(header->magic, header->magic + 8, expected_header.magic) &&
+           "[ERROR] The file is not a binary demand file!");
+    assert(header->version == expected_header.version && "[ERROR] Unsupported binary demand file version!");
+    assert(header->record_size == sizeof(DemandRecord) && "[ERROR] Unexpected record size in binary demand file!");
+    assert(sizeof(DemandFileHeader) + header->num_of_records * sizeof(DemandRecord) <= file_size &&
+           "[ERROR] The binary demand file is truncated!");
+    base_date = std::string(header->base_date, strnlen(header->base_date, sizeof(header->base_date)));
+    auto num_of_records = static_cast<size_t>(header->num_of_records);
+
+    // The mapping is released when the last copy of the records is destroyed.
+    std::shared_ptr<const DemandRecord> records(
+            reinterpret_cast<const DemandRecord *>(static_cast<const char *>(mapped_address) +
+                                                   sizeof(DemandFileHeader)),
+            [mapped_address, file_size](const DemandRecord *) { munmap(mapped_address, file_size); });
+    return {records, num_of_records};
+}
+}  // namespace
 
 DemandGenerator::DemandGenerator(std::string _path_to_taxi_data,
                                  std::string _simulation_start_time,
-                                 float _request_density) {
+                                 float _request_density,
+                                 std::vector<std::vector<size_t>> _neighbouring_nodes)
+    : neighbouring_nodes_(std::move(_neighbouring_nodes)) {
 
     TIMER_START(t)
-    all_requests_ = LoadRequestsFromCsvFile(_path_to_taxi_data);
-    init_request_time_ms_ = ComputeTheAccumulatedSecondsFrom0Clock(_simulation_start_time) * 1000;
-    while (all_requests_[init_request_idx_].request_time_ms < init_request_time_ms_){
-        init_request_idx_++;
+    std::string base_date;
+    if (_path_to_taxi_data.size() > 4 && _path_to_taxi_data.substr(_path_to_taxi_data.size() - 4) == ".bin") {
+        std::tie(mapped_records_, num_of_mapped_records_) = MapRequestsFromBinaryFile(_path_to_taxi_data, base_date);
+    } else {
+        CheckFileExistence(_path_to_taxi_data);
+        csv_reader_ = std::make_shared<csv::CSVReader>(_path_to_taxi_data);
+        base_date = _simulation_start_time.substr(0, 10);
     }
+    base_date_time_s_ = ConvertTimeDateToSeconds(base_date + " 00:00:00");
+    auto init_request_time_s = ConvertTimeDateToSeconds(_simulation_start_time) - base_date_time_s_;
+    assert(init_request_time_s >= 0 && "[ERROR] The simulation starts before the base date of the demand data!");
+    init_request_time_ms_ = static_cast<uint64_t>(init_request_time_s) * 1000;
     request_density_ = _request_density;
+    assert(request_density_ > 0 && "[ERROR] The request density must be positive!");
+    assert((request_density_ <= 1 || !neighbouring_nodes_.empty()) &&
+           "[ERROR] The neighbouring nodes are needed to upsample the demand data!");
+
+    // Seek to the first request at or after the simulation start time. The binary data is binary searched, while the
+    // csv data has to be read through.
+    if (mapped_records_) {
+        next_mapped_record_idx_ =
+                std::lower_bound(mapped_records_.get(), mapped_records_.get() + num_of_mapped_records_,
+                                 init_request_time_ms_, [](const DemandRecord &record, uint64_t time_ms) {
+                                     return record.request_time_s * 1000ull < time_ms;
+                                 }) - mapped_records_.get();
+        num_of_released_mapped_records_ = next_mapped_record_idx_;
+    } else {
+        while (ReadNextRecord() && window_.back().request_time_s * 1000ull < init_request_time_ms_) {
+            window_.pop_back();
+        }
+    }
 
     fmt::print("[INFO] Demand Generator is ready.");
     TIMER_END(t)
@@ -35,14 +113,28 @@ std::vector<Request> DemandGenerator::operator()(uint64_t target_system_time_ms)
     system_time_ms_ = target_system_time_ms;
     std::vector<Request> requests = {};
 
-    size_t new_request_idx = init_request_idx_ + (size_t)(current_request_count_ / request_density_);
-    while (all_requests_[new_request_idx].request_time_ms < system_time_ms_ + init_request_time_ms_){
-        Request new_request = all_requests_[new_request_idx];
-        new_request.request_time_ms -= init_request_time_ms_;
+    if (request_density_ > 1) {
+        GenerateUpsampledRequests(requests);
+        return requests;
+    }
+
+    size_t new_request_idx = (size_t)(current_request_count_ / request_density_);
+    while (true) {
+        // Read forward until the window covers the new request.
+        while (window_start_idx_ + window_.size() <= new_request_idx) {
+            if (!ReadNextRecord()) { return requests; }
+        }
+        const auto &record = window_[new_request_idx - window_start_idx_];
+        if (record.request_time_s * 1000ull >= system_time_ms_ + init_request_time_ms_) { break; }
+
+        Request new_request;
+        new_request.origin_node_id = record.origin_node_id;
+        new_request.destination_node_id = record.destination_node_id;
+        new_request.request_time_ms = record.request_time_s * 1000ull - init_request_time_ms_;
 
 //        if (DEBUG_PRINT) {
-//            fmt::print("[DEBUG] Generated request index {} ({}): origin({}), dest({}).\n",
-//                       new_request_idx - init_request_idx_, new_request.request_time_date,
+//            fmt::print("[DEBUG] Generated request index {} ({}s): origin({}), dest({}).\n",
+//                       new_request_idx, new_request.request_time_ms / 1000,
 //                       new_request.origin_node_id, new_request.destination_node_id);
 //        }
 
@@ -50,25 +142,191 @@ std::vector<Request> DemandGenerator::operator()(uint64_t target_system_time_ms)
             break;
         }
         current_request_count_++;
-        new_request_idx = init_request_idx_ + (size_t)(current_request_count_ / request_density_);
+        new_request_idx = (size_t)(current_request_count_ / request_density_);
+        requests.push_back(new_request);
+
+        // The records before the new request are no longer needed.
+        while (window_start_idx_ < new_request_idx && !window_.empty()) {
+            window_.pop_front();
+            window_start_idx_++;
+        }
+    }
+    return requests;
+}
+
+void DemandGenerator::GenerateUpsampledRequests(std::vector<Request> &requests) {
+    auto request_time_order = [](const Request &a, const Request &b) { return a.request_time_ms > b.request_time_ms; };
+
+    // Each record is generated as floor((i + 1) * density) - floor(i * density) requests, i.e. itself and its clones.
+    // The clones are later than the record, so they wait in the heap until the system time reaches them.
+    while (!window_.empty() || ReadNextRecord()) {
+        const auto record = window_.front();
+        if (record.request_time_s * 1000ull >= system_time_ms_ + init_request_time_ms_ || record.origin_node_id == 0) {
+            break;
+        }
+        Request new_request;
+        new_request.origin_node_id = record.origin_node_id;
+        new_request.destination_node_id = record.destination_node_id;
+        new_request.request_time_ms = record.request_time_s * 1000ull - init_request_time_ms_;
+        requests.push_back(new_request);
+
+        auto num_of_copies = static_cast<size_t>((window_start_idx_ + 1) * static_cast<double>(request_density_)) -
+                             static_cast<size_t>(window_start_idx_ * static_cast<double>(request_density_));
+        for (auto clone_idx = 1; clone_idx < num_of_copies; clone_idx++) {
+            pending_cloned_requests_.push_back(CloneRecord(record, window_start_idx_, clone_idx));
+            std::push_heap(pending_cloned_requests_.begin(), pending_cloned_requests_.end(), request_time_order);
+        }
+        current_request_count_ += num_of_copies;
+        window_.pop_front();
+        window_start_idx_++;
+    }
+
+    while (!pending_cloned_requests_.empty() &&
+           pending_cloned_requests_.front().request_time_ms < system_time_ms_) {
+        std::pop_heap(pending_cloned_requests_.begin(), pending_cloned_requests_.end(), request_time_order);
+        requests.push_back(pending_cloned_requests_.back());
+        pending_cloned_requests_.pop_back();
+    }
+
+    std::stable_sort(requests.begin(), requests.end(), [](const Request &a, const Request &b) {
+        return a.request_time_ms < b.request_time_ms;
+    });
+}
+
+Request DemandGenerator::CloneRecord(const DemandRecord &record, size_t record_idx, size_t clone_idx) const {
+    // A hash of the record and clone indices, so that the clones do not depend on the epoch length. The record index
+    // is mixed before the clone index is, so that no two (record, clone) pairs share a hash at any request density.
+    auto hash = SplitMix64(SplitMix64(record_idx) ^ clone_idx);
+
+    Request cloned_request;
+    cloned_request.origin_node_id = record.origin_node_id;
+    cloned_request.destination_node_id = record.destination_node_id;
+    const auto &origin_neighbours = neighbouring_nodes_[record.origin_node_id];
+    const auto &destination_neighbours = neighbouring_nodes_[record.destination_node_id];
+    if (!origin_neighbours.empty()) {
+        cloned_request.origin_node_id = origin_neighbours[(hash >> 16) % origin_neighbours.size()];
+    }
+    if (!destination_neighbours.empty()) {
+        cloned_request.destination_node_id = destination_neighbours[(hash >> 40) % destination_neighbours.size()];
+    }
+    if (cloned_request.origin_node_id == cloned_request.destination_node_id) {
+        cloned_request.origin_node_id = record.origin_node_id;
+        cloned_request.destination_node_id = record.destination_node_id;
+    }
+    cloned_request.request_time_ms =
+            record.request_time_s * 1000ull - init_request_time_ms_ + hash % clone_max_time_offset_ms;
+    return cloned_request;
+}
+
+bool DemandGenerator::ReadNextRecord() {
+    if (mapped_records_) {
+        if (next_mapped_record_idx_ >= num_of_mapped_records_) { return false; }
+        window_.push_back(mapped_records_.get()[next_mapped_record_idx_++]);
+
+        // Release the memory pages of the records that have been read, every few MB, so that the resident memory
+        // stays bounded no matter how long the data is.
+        const size_t release_size = 4 * 1024 * 1024;
+        const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const auto *first_released_address =
+                reinterpret_cast<const char *>(mapped_records_.get() + num_of_released_mapped_records_);
+        const auto *read_address = reinterpret_cast<const char *>(mapped_records_.get() + next_mapped_record_idx_);
+        if (static_cast<size_t>(read_address - first_released_address) >= release_size) {
+            auto page_begin = reinterpret_cast<uintptr_t>(first_released_address) / page_size * page_size;
+            auto page_end = reinterpret_cast<uintptr_t>(read_address) / page_size * page_size;
+            madvise(reinterpret_cast<void *>(page_begin), page_end - page_begin, MADV_DONTNEED);
+            num_of_released_mapped_records_ = next_mapped_record_idx_;
+        }
+    } else {
+        csv::CSVRow row;
+        int64_t request_time_s = -1;
+        while (request_time_s < 0) {
+            if (!csv_reader_->read_row(row)) { return false; }
+            // The requests before the base date (the day of the simulation) are skipped.
+            auto request_time_date = row["ptime"].get<csv::string_view>();
+            request_time_s = static_cast<int64_t>(
+                    ConvertTimeDateToSeconds(request_time_date.data(), request_time_date.size())) - base_date_time_s_;
+        }
+        DemandRecord record;
+        record.origin_node_id = row["onid"].get<uint32_t>();
+        record.destination_node_id = row["dnid"].get<uint32_t>();
+        record.request_time_s = static_cast<uint32_t>(request_time_s);
+        window_.push_back(record);
+    }
+    assert((window_.size() < 2 || window_[window_.size() - 2].request_time_s <= window_.back().request_time_s) &&
+           "[ERROR] The demand data must be sorted by request time!");
+    return true;
+}
+
+SyntheticDemandGenerator::SyntheticDemandGenerator(std::string _path_to_taxi_data,
+                                                   std::string _simulation_start_time,
+                                                   float _demand_scale,
+                                                   uint64_t _random_seed)
+    : random_engine_(_random_seed) {
+    assert(_demand_scale > 0 && "[ERROR] The demand scale of the synthetic demand must be positive!");
+
+    TIMER_START(t)
+    // Fit the model to all the requests of the day of the simulation start.
+    DemandGenerator historical_demand_generator{_path_to_taxi_data, _simulation_start_time.substr(0, 10) + " 00:00:00",
+                                                1.0};
+    auto historical_requests = historical_demand_generator(24 * 3600 * 1000);
+    assert(!historical_requests.empty() && "[ERROR] No request in the demand data to fit the synthetic demand!");
+    for (const auto &request : historical_requests) {
+        od_pairs_by_hour_[request.request_time_ms / (3600 * 1000)].emplace_back(request.origin_node_id,
+                                                                               request.destination_node_id);
+    }
+    for (auto hour = 0; hour < 24; hour++) {
+        arrival_rates_by_hour_[hour] = od_pairs_by_hour_[hour].size() * _demand_scale / (3600 * 1000);
+    }
+
+    init_request_time_ms_ =
+            static_cast<uint64_t>(ComputeTheAccumulatedSecondsFrom0Clock(_simulation_start_time)) * 1000;
+    next_request_time_ms_ = SampleNextRequestTime(0.0);
+
+    fmt::print("[INFO] Synthetic Demand Generator is ready (fitted to {} requests, scale = {}).",
+               historical_requests.size(), _demand_scale);
+    TIMER_END(t)
+}
+
+std::vector<Request> SyntheticDemandGenerator::operator()(uint64_t target_system_time_ms) {
+    assert(system_time_ms_ <= target_system_time_ms &&
+           "[ERROR] The target_system_time should be no less than the current system time in "
+           "Synthetic Demand Generator!");
+
+    // System time moves to the target.
+    system_time_ms_ = target_system_time_ms;
+    std::vector<Request> requests = {};
+
+    while (next_request_time_ms_ < system_time_ms_) {
+        const auto &od_pairs = od_pairs_by_hour_[GetHourOfDay(next_request_time_ms_)];
+        const auto &od_pair = od_pairs[std::uniform_int_distribution<size_t>(0, od_pairs.size() - 1)(random_engine_)];
+
+        Request new_request;
+        new_request.origin_node_id = od_pair.first;
+        new_request.destination_node_id = od_pair.second;
+        new_request.request_time_ms = static_cast<uint64_t>(next_request_time_ms_);
         requests.push_back(new_request);
+
+        next_request_time_ms_ = SampleNextRequestTime(next_request_time_ms_);
     }
     return requests;
 }
 
-std::vector<Request> LoadRequestsFromCsvFile(std::string path_to_csv) {
-    CheckFileExistence(path_to_csv);
-    std::vector<Request> all_requests = {};
-    csv::CSVReader reader(path_to_csv);
-
-    for (csv::CSVRow& row: reader) {     // input iterator
-        Request request;
-        request.origin_node_id = row["onid"].get<size_t>();
-        request.destination_node_id = row["dnid"].get<size_t>();
-        request.request_time_date = row["ptime"].get();
-        request.request_time_ms = ComputeTheAccumulatedSecondsFrom0Clock(request.request_time_date) * 1000;
-        all_requests.push_back(request);
+double SyntheticDemandGenerator::SampleNextRequestTime(double system_time_ms) {
+    // The rate is constant within an hour. As the Poisson process is memoryless, an arrival sampled beyond the end of
+    // the hour is discarded and sampled again from the end of the hour with the rate of the next hour.
+    while (true) {
+        auto end_of_hour_ms = std::floor((init_request_time_ms_ + system_time_ms) / (3600 * 1000) + 1) * 3600 * 1000 -
+                              init_request_time_ms_;
+        auto arrival_rate = arrival_rates_by_hour_[GetHourOfDay(system_time_ms)];
+        if (arrival_rate > 0) {
+            auto next_request_time_ms =
+                    system_time_ms + std::exponential_distribution<double>(arrival_rate)(random_engine_);
+            if (next_request_time_ms < end_of_hour_ms) { return next_request_time_ms; }
+        }
+        system_time_ms = end_of_hour_ms;
     }
-//    fmt::print("[DEBUG] Load request data from {}, with {} requests.\n", path_to_csv, all_requests.size());
-    return std::move(all_requests);
-}
\ No newline at end of file
+}
+
+size_t SyntheticDemandGenerator::GetHourOfDay(double system_time_ms) const {
+    return static_cast<size_t>((init_request_time_ms_ + system_time_ms) / (3600 * 1000)) % 24;
+}
@@ -6,38 +6,148 @@
 #include "utility/utility_functions.hpp"
 #include "utility/csv.hpp"
 
+#include <array>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <random>
+
+/// \brief The header at the start of the binary demand file.
+/// \details A binary demand file is a DemandFileHeader followed by num_of_records DemandRecord sorted by request time.
+/// It is converted from the taxi data csv file by python/convert_demand_to_binary.py.
+struct DemandFileHeader {
+    char magic[8] = {'A', 'M', 'o', 'D', '2', 'D', 'M', 'D'};
+    uint32_t version = 1;
+    uint32_t record_size = 12;
+    uint64_t num_of_records = 0;
+    char base_date[16] = {};  // "%Y-%m-%d", the day whose 0 clock is the origin of the request times
+};
+
+/// \brief The fixed-width record of a request in the demand data.
+struct DemandRecord {
+    uint32_t origin_node_id = 0;
+    uint32_t destination_node_id = 0;
+    uint32_t request_time_s = 0;  // seconds from the 0 clock of the base date
+};
+
+static_assert(sizeof(DemandFileHeader) == 40, "Unexpected padding in DemandFileHeader!");
+static_assert(sizeof(DemandRecord) == 12, "Unexpected padding in DemandRecord!");
 
 /// \brief Stateful functor that generates orders based on demand data.
+/// \details The demand data is streamed: the generator seeks to the simulation start time and then reads the records
+/// forward as the system time advances, keeping only the records not yet generated (or skipped) in memory. The data
+/// may span multiple days, as long as it is sorted by request time.
+/// A request density below 1 thins the data, while a density above 1 upsamples it: each record is generated along with
+/// deterministic clones, each shifted by a small time offset and with its origin and destination moved to neighbouring
+/// nodes.
 class DemandGenerator {
   public:
-    /// \brief Constructor.
+    /// \brief Constructor. The demand data is read from a csv file, or mapped from a binary file (ending in ".bin").
+    /// \param _neighbouring_nodes the neighbouring nodes of each node (indexed by node_id), where the cloned requests
+    /// are moved to. Only needed if the request density is above 1.
     explicit DemandGenerator(std::string _path_to_taxi_data, std::string _simulation_start_time,
-                             float _request_density);
+                             float _request_density, std::vector<std::vector<size_t>> _neighbouring_nodes = {});
 
     /// \brief Main functor that generates the requests till the target system time.
     std::vector<Request> operator()(uint64_t target_system_time_ms);
 
+    /// \brief The max travel time between a node and its neighbouring nodes, where the cloned requests are moved to.
+    static constexpr float clone_max_travel_time_to_neighbouring_node_s = 60.0;
+
+    /// \brief The max time offset of a cloned request from its original request.
+    static constexpr uint64_t clone_max_time_offset_ms = 120 * 1000;
+
 private:
+    /// \brief Generate the requests till the system time, cloning each record (request density above 1).
+    void GenerateUpsampledRequests(std::vector<Request> &requests);
+
+    /// \brief Clone the record with the given index, deterministically.
+    Request CloneRecord(const DemandRecord &record, size_t record_idx, size_t clone_idx) const;
+
+    /// \brief Read the next record of the demand data to the back of the window. Returns false at the end of data.
+    bool ReadNextRecord();
+
     /// \brief The system time starting from 0.
     uint64_t system_time_ms_ = 0;
 
-    /// \brief The real taxi trip data loaded from a csv file.
-    std::vector<Request> all_requests_;
+    /// \brief The records read from the demand data and not yet passed, the first one being the request with index
+    /// window_start_idx_ (counted from the first request at or after the simulation start time).
+    std::deque<DemandRecord> window_;
+
+    /// \brief The index of the first record in the window.
+    size_t window_start_idx_ = 0;
+
+    /// \brief The reader of the csv demand data (nullptr for a binary file). (Shared, as the reader is not copyable.)
+    std::shared_ptr<csv::CSVReader> csv_reader_;
+
+    /// \brief The records mapped from the binary demand data (nullptr for a csv file). The shared_ptr owns the
+    /// memory mapping, so that the functor can be copied and moved.
+    std::shared_ptr<const DemandRecord> mapped_records_;
+
+    /// \brief The number of records in the binary demand data.
+    size_t num_of_mapped_records_ = 0;
+
+    /// \brief The index of the next mapped record to read.
+    size_t next_mapped_record_idx_ = 0;
+
+    /// \brief The number of mapped records whose memory pages have been released after being read.
+    size_t num_of_released_mapped_records_ = 0;
+
+    /// \brief The 0 clock of the base date (in seconds, as ConvertTimeDateToSeconds), the origin of the record times.
+    int32_t base_date_time_s_ = 0;
 
     /// \brief The init request start time, determined by the simulation time.
     uint64_t init_request_time_ms_ = 0;
 
-    /// \brief The init request index when the simulation starts.
-    size_t init_request_idx_ = 0;
-
     /// \brief The number of requests that have been generated.
     size_t current_request_count_ = 0;
 
-    /// \brief The percentage of taxi data considered.
+    /// \brief The percentage of taxi data considered (above 1 if the data is upsampled).
     float request_density_ = 1.0;
+
+    /// \brief The neighbouring nodes of each node, indexed by node_id (upsampling only).
+    std::vector<std::vector<size_t>> neighbouring_nodes_;
+
+    /// \brief The cloned requests not yet generated, as a min heap of their request times (upsampling only).
+    std::vector<Request> pending_cloned_requests_;
 };
 
-/// \brief // A function loading the taxi trip data from a csv file.
-static std::vector<Request> LoadRequestsFromCsvFile(std::string path_to_csv);
+/// \brief Stateful functor that generates synthetic orders, sampled from a model fitted to the demand data.
+/// \details The model is fitted to the requests of the whole day of the simulation start: the arrivals follow a Poisson
+/// process whose rate in each hour of the day is the hourly request count of the data times the demand scale, and the
+/// origin/destination of each request is drawn from the empirical OD pairs of its hour. The requests are reproducible
+/// for a given seed, and the scale can be any positive number (e.g. 2-10 times the historical demand).
+class SyntheticDemandGenerator {
+  public:
+    /// \brief Constructor.
+    explicit SyntheticDemandGenerator(std::string _path_to_taxi_data, std::string _simulation_start_time,
+                                      float _demand_scale, uint64_t _random_seed);
+
+    /// \brief Main functor that generates the requests till the target system time.
+    std::vector<Request> operator()(uint64_t target_system_time_ms);
+
+private:
+    /// \brief Sample the time of the next request arriving after the given system time.
+    double SampleNextRequestTime(double system_time_ms);
+
+    /// \brief The hour of the day at the given system time.
+    size_t GetHourOfDay(double system_time_ms) const;
+
+    /// \brief The system time starting from 0.
+    uint64_t system_time_ms_ = 0;
+
+    /// \brief The OD pairs (origin and destination node ids) of the requests in each hour of the day in the data.
+    std::array<std::vector<std::pair<size_t, size_t>>, 24> od_pairs_by_hour_;
+
+    /// \brief The (scaled) arrival rate of the requests in each hour of the day, in requests per millisecond.
+    std::array<double, 24> arrival_rates_by_hour_ = {};
+
+    /// \brief The time of the simulation start, in milliseconds from the 0 clock of its day.
+    uint64_t init_request_time_ms_ = 0;
+
+    /// \brief The system time of the next request.
+    double next_request_time_ms_ = 0.0;
+
+    /// \brief The random engine sampling the arrivals and the OD pairs.
+    std::mt19937_64 random_engine_;
+};
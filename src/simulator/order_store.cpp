@@ -0,0 +1,37 @@
+#include "order_store.hpp"
+
+#include <cstdio>
+
+OrderStore::~OrderStore() {
+    if (archive_file_.is_open()) {
+        archive_file_.close();
+        std::remove(path_to_archive_file_.c_str());
+    }
+}
+
+void OrderStore::SpillArchiveToFile(const std::string &path_to_archive_file) {
+    assert(num_of_archived_orders_ == 0 && "The archive file must be set before any order is archived!");
+    path_to_archive_file_ = path_to_archive_file;
+    archive_file_.open(path_to_archive_file_, std::ios::out | std::ios::binary | std::ios::trunc);
+    assert(archive_file_.is_open() && "Failed to open the order archive file!");
+}
+
+void OrderStore::push_back(Order order) {
+    assert(order.id == size() && "The order id must equal its index!");
+    hot_orders_.push_back(std::move(order));
+}
+
+void OrderStore::ArchiveOrdersBefore(size_t order_id) {
+    while (num_of_archived_orders_ < order_id && !hot_orders_.empty()) {
+        const auto &order = hot_orders_.front();
+        assert((order.status == OrderStatus::COMPLETE || order.status == OrderStatus::WALKAWAY) &&
+               "Only the complete or walkaway orders can be archived!");
+        if (path_to_archive_file_.empty()) {
+            archived_orders_.push_back(order);
+        } else {
+            archive_file_.write(reinterpret_cast<const char *>(&order), sizeof(Order));
+        }
+        hot_orders_.pop_front();
+        num_of_archived_orders_++;
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#undef NDEBUG
+#include <assert.h>
+
+/// \brief The store of all orders created in the simulation, accessed by order id.
+/// \details The orders are created with increasing ids. The recent ones (from the oldest order that may still be
+/// active) are kept in a hot deque, where order id x is at slot x - num_of_archived_orders. The older ones, which are
+/// all complete or walkaway, are moved to a cold append-only archive, kept in memory or spilled to a file. So the hot
+/// working set stays flat no matter how long the simulation runs. Only the hot orders can be accessed by id.
+class OrderStore {
+  public:
+    /// \brief Constructor.
+    OrderStore() = default;
+
+    /// \brief Destructor. Remove the archive file, if any.
+    ~OrderStore();
+
+    /// \brief Delete the other constructors. Rule of five.
+    OrderStore(const OrderStore &other) = delete;
+    OrderStore(OrderStore &&other) = delete;
+    OrderStore &operator=(const OrderStore &other) = delete;
+    OrderStore &operator=(OrderStore &&other) = delete;
+
+    /// \brief Spill the archived orders to a file instead of keeping them in memory. Called before any archiving.
+    void SpillArchiveToFile(const std::string &path_to_archive_file);
+
+    /// \brief Get the hot order with the given id.
+    Order &operator[](size_t order_id) {
+        assert(order_id >= num_of_archived_orders_ && "The order has been archived!");
+        return hot_orders_[order_id - num_of_archived_orders_];
+    }
+    const Order &operator[](size_t order_id) const {
+        assert(order_id >= num_of_archived_orders_ && "The order has been archived!");
+        return hot_orders_[order_id - num_of_archived_orders_];
+    }
+
+    /// \brief The number of orders created, i.e. the id of the next order.
+    size_t size() const { return num_of_archived_orders_ + hot_orders_.size(); }
+
+    /// \brief The id of the first hot order (the number of archived orders).
+    size_t GetFirstHotOrderId() const { return num_of_archived_orders_; }
+
+    /// \brief Add a new order, whose id must be size().
+    void push_back(Order order);
+
+    /// \brief Get the last created order.
+    Order &back() { return hot_orders_.back(); }
+
+    /// \brief Move the orders with id below order_id to the archive. They must all be complete or walkaway.
+    void ArchiveOrdersBefore(size_t order_id);
+
+    /// \brief Call func on each order with id from first_order_id, the archived ones (read back from the archive
+    /// file if spilled) and then the hot ones, in the order of ids.
+    template <typename Func>
+    void ForEachOrder(Func func, size_t first_order_id = 0) const;
+
+  private:
+    /// \brief The orders that are not archived, the order with id num_of_archived_orders_ first.
+    std::deque<Order> hot_orders_;
+
+    /// \brief The number of archived orders.
+    size_t num_of_archived_orders_ = 0;
+
+    /// \brief The archived orders, if they are kept in memory.
+    std::vector<Order> archived_orders_;
+
+    /// \brief The path to the archive file, empty if the archived orders are kept in memory.
+    std::string path_to_archive_file_ = "";
+
+    /// \brief The archive file, to which the archived orders are appended. (Flushed before being read.)
+    mutable std::ofstream archive_file_;
+};
+
+template <typename Func>
+void OrderStore::ForEachOrder(Func func, size_t first_order_id) const {
+    if (first_order_id < num_of_archived_orders_) {
+        if (path_to_archive_file_.empty()) {
+            for (auto i = first_order_id; i < num_of_archived_orders_; i++) { func(archived_orders_[i]); }
+        } else {
+            // The archive file is read back in chunks, so that the memory use stays bounded.
+            archive_file_.flush();
+            std::ifstream archive_file(path_to_archive_file_, std::ios::in | std::ios::binary);
+            assert(archive_file.is_open() && "Failed to read the order archive file!");
+            archive_file.seekg(first_order_id * sizeof(Order));
+            std::vector<Order> chunk(4096);
+            for (auto i = first_order_id; i < num_of_archived_orders_; i += chunk.size()) {
+                auto num_of_orders_in_chunk = std::min(chunk.size(), num_of_archived_orders_ - i);
+                archive_file.read(reinterpret_cast<char *>(chunk.data()), num_of_orders_in_chunk * sizeof(Order));
+                assert(archive_file && "Failed to read the order archive file!");
+                for (auto j = 0; j < num_of_orders_in_chunk; j++) { func(chunk[j]); }
+            }
+        }
+        first_order_id = num_of_archived_orders_;
+    }
+    for (auto i = first_order_id - num_of_archived_orders_; i < hot_orders_.size(); i++) { func(hot_orders_[i]); }
+}
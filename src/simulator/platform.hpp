@@ -4,14 +4,38 @@
 #pragma once
 
 #include "vehicle.hpp"
+#include "datalog.hpp"
 #include "utility/tqdm.h"
+#include "utility/worker_pool.hpp"
 #include "dispatcher/dispatch_gi.hpp"
 #include "dispatcher/dispatch_osp.hpp"
 #include "dispatcher/dispatch_sba.hpp"
 #include "rebalancer/rebalancing_npo.hpp"
 #include "rebalancer/rebalancing_rvs.hpp"
 
+#include <array>
 #include <iomanip>
+#include <numeric>
+#include <queue>
+#include <thread>
+
+/// \brief The service quality and fleet numbers of the main simulation, as printed by the report.
+struct SimulationReport {
+    size_t num_of_orders = 0;            // the orders requested in the main simulation
+    size_t num_of_walkaway_orders = 0;
+    size_t num_of_complete_orders = 0;
+    size_t num_of_onboard_orders = 0;
+    double service_rate = 0.0;           // (complete + onboard) / all, in percent
+    double avg_shortest_travel_s = 0.0;  // of the complete orders
+    double avg_wait_s = 0.0;
+    double avg_delay_s = 0.0;
+    double total_dist_km = 0.0;          // of the whole fleet (include empty and rebalancing)
+    double avg_dist_km = 0.0;            // per vehicle
+    double empty_dist_rate = 0.0;        // in percent of the distance
+    double rebl_dist_rate = 0.0;
+    double avg_load_dist = 0.0;          // the average load weighted by distance
+    double main_sim_runtime_s = 0.0;     // the wall time of the main simulation
+};
 
 /// \brief The agent-based modeling platform that simulates the mobility-on-demand system.
 template <typename RouterFunc, typename DemandGeneratorFunc>
@@ -34,18 +58,43 @@ class Platform {
     /// \brief Run simulation. The master function that manages the entire simulation process.
     void RunSimulation(std::time_t simulation_start_time_stamp, float total_init_time_s);
 
+    /// \brief Get the numbers of the last created report, i.e. of the whole run once RunSimulation() returns.
+    const SimulationReport &getReport() const { return report_; }
+
   private:
     /// \brief Run simulation for one cycle. Invoked repetetively by run_simulation().
     void RunCycle(std::string progress_phase = "");
 
     /// \brief Advance all vehicles for the given time and move forward the system time.
+    /// In event-driven mode, only the vehicles having events (waypoint arrivals) within the time are advanced.
     void AdvanceVehicles(uint64_t time_ms);
 
+    /// \brief Apply the advance function to each of the vehicles, with the vehicles split into chunks for threads.
+    /// Returns the number of picked and dropped orders.
+    template <typename AdvanceFunc>
+    std::pair<size_t, size_t> AdvanceEachVehicle(AdvanceFunc advance_func);
+
+    /// \brief Advance the vehicle from the time it was last updated to the given time (event-driven mode).
+    std::pair<std::vector<size_t>, std::vector<size_t>> AdvanceVehicleToTime(Vehicle &vehicle, uint64_t time_ms);
+
+    /// \brief Bring the positions of all (or only the idle) vehicles to the current system time (event-driven mode).
+    void SyncVehiclesToSystemTime(bool only_idle_vehicles = false);
+
+    /// \brief Add the next event of the vehicle to the event queue, if it is moving (event-driven mode).
+    void PushNextEventOfVehicle(const Vehicle &vehicle);
+
+    /// \brief Rebuild the event queue after the vehicles' schedules are changed (event-driven mode).
+    void RebuildVehicleEventQueue();
+
     /// \brief Generate orders at the end of each cycle.
     std::vector<size_t> GenerateOrders();
 
     /// \brief Write the data of the current simulation state to datalog.
-    void WriteToDatalog();
+    /// \param schedules_may_have_been_rebuilt true if the dispatcher or the rebalancer has run since the last frame.
+    void WriteToDatalog(bool schedules_may_have_been_rebuilt = false);
+
+    /// \brief Write a row of the metrics of the current epoch to the epoch metrics file.
+    void WriteEpochMetrics(size_t num_of_new_received_orders);
 
     /// \brief Create the report based on the statistical analysis using the simulated data.
     void CreateReport(std::time_t simulation_start_time_stamp, float total_init_time_s, float main_runtime_s);
@@ -77,20 +126,78 @@ class Platform {
     /// \brief The time when the simulation is terminated in milliseconds.
     uint64_t system_shutdown_time_ms_ = 0;
 
-    /// \brief The vector of orders created during the entire simulation process.
-    std::vector<Order> orders_;
+    /// \brief The orders created during the entire simulation process, the complete/walkaway ones being archived.
+    OrderStore orders_;
+
+    /// \brief The ids of the active (pending, picking or onboard) orders in ascending order, so that the per-epoch
+    /// work scales with the active orders instead of all orders. The complete and walkaway orders are removed once
+    /// per epoch, so the vector may still hold a few orders completed since then.
+    std::vector<size_t> active_order_ids_;
+
+    /// \brief The number of complete/walkaway orders that have been removed from active_order_ids_.
+    size_t num_of_removed_complete_orders_ = 0;
+    size_t num_of_removed_walkaway_orders_ = 0;
+
+    /// \brief The number of removed orders requested in the main simulation, and the complete ones among them.
+    size_t num_of_removed_main_sim_orders_ = 0;
+    size_t num_of_removed_main_sim_complete_orders_ = 0;
+
+    /// \brief The first active order id at the last epoch. The orders before it are archived at the current epoch,
+    /// one epoch after they become inactive, so that their final statuses have been written to the datalog.
+    size_t order_archive_horizon_ = 0;
 
     /// \brief The vector of vehicles.
     std::vector<Vehicle> vehicles_;
 
+    /// \brief The structure-of-arrays mirror of the vehicles' hot fields, scanned by the fleet-wide filters.
+    FleetState fleet_state_;
+
     /// \brief The method used to assign orders to vehicles.
     DispatcherMethod dispatcher_ = DispatcherMethod::GI;
 
     /// \brief The method used to reposition idle vehicles.
     RebalancerMethod rebalancer_ = RebalancerMethod::NONE;
 
-    /// \brief The ofstream that outputs to the datalog.
-    std::ofstream datalog_ofstream_;
+    /// \brief The queue of vehicle events (the time of the next waypoint arrival, vehicle id), the earliest first.
+    std::priority_queue<std::pair<uint64_t, size_t>, std::vector<std::pair<uint64_t, size_t>>,
+            std::greater<std::pair<uint64_t, size_t>>> vehicle_events_;
+
+    /// \brief The system time up to which each vehicle has been advanced (event-driven mode).
+    std::vector<uint64_t> vehicle_updated_time_ms_;
+
+    /// \brief The number of epochs at which the dispatcher exceeded the latency budget.
+    size_t num_of_epochs_over_latency_budget_ = 0;
+
+    /// \brief The max computational time of the dispatcher at one epoch in milliseconds.
+    uint64_t max_dispatch_time_ms_ = 0;
+
+    /// \brief The writer that outputs to the datalog.
+    DatalogWriter datalog_writer_;
+
+    /// \brief The builder that takes the snapshots of the simulation state for the datalog.
+    DatalogFrameBuilder datalog_frame_builder_;
+
+    /// \brief The snapshot written to the datalog, kept as a member to reuse its buffers across frames.
+    DatalogFrame datalog_frame_;
+
+    /// \brief The csv file of the per-epoch metrics, not open if there is no output.
+    std::ofstream epoch_metrics_file_;
+
+    /// \brief The number of columns of the vehicle-trip pairs in the epoch metrics, the last one counting the pairs of
+    /// this size and above.
+    size_t num_of_trip_size_columns_ = 0;
+
+    /// \brief The total time of each phase at the last epoch, to get the time of each phase at the current epoch.
+    std::array<uint64_t, num_of_profiler_phases> phase_total_ns_at_last_epoch_ = {};
+
+    /// \brief The numbers of the last created report.
+    SimulationReport report_;
+
+    /// \brief The Gurobi environments of the ILP threads, started at their first use and kept across epochs.
+    IlpSolverEnvs ilp_solver_envs_;
+
+    /// \brief The persistent threads advancing the vehicles, created once instead of at every frame.
+    WorkerPool vehicle_worker_pool_;
 };
 
 // Implementation is put in a separate file for clarity and maintainability.
@@ -13,7 +13,11 @@ Platform<RouterFunc, DemandGeneratorFunc>::Platform(PlatformConfig _platform_con
                                                     RouterFunc _router_func,
                                                     DemandGeneratorFunc _demand_generator_func)
     : platform_config_(std::move(_platform_config)), router_func_(std::move(_router_func)),
-      demand_generator_func_(std::move(_demand_generator_func)) {
+      demand_generator_func_(std::move(_demand_generator_func)),
+      ilp_solver_envs_(platform_config_.simulation_config.num_of_threads),
+      vehicle_worker_pool_(std::max(static_cast<size_t>(1), std::min(
+              platform_config_.simulation_config.num_of_threads,
+              platform_config_.mod_system_config.fleet_config.fleet_size))) {
 
     // Initialize the fleet.
     const auto &fleet_config = platform_config_.mod_system_config.fleet_config;
@@ -27,7 +31,13 @@ Platform<RouterFunc, DemandGeneratorFunc>::Platform(PlatformConfig _platform_con
         vehicle.pos = router_func_.getNodePos(router_func_.getVehicleStationId(station_idx));
         vehicles_.push_back(vehicle);
     }
+    InitFleetState(fleet_state_, vehicles_);
+    vehicle_updated_time_ms_.assign(vehicles_.size(), 0);
 
+    // Spill the archived orders to disk, if asked.
+    if (!platform_config_.simulation_config.path_to_order_archive.empty()) {
+        orders_.SpillArchiveToFile(platform_config_.simulation_config.path_to_order_archive);
+    }
 
     // Initialize the simulation times.
     system_time_ms_ = 0;
@@ -79,11 +89,53 @@ Platform<RouterFunc, DemandGeneratorFunc>::Platform(PlatformConfig _platform_con
     // Open the output datalog file.
     const auto &datalog_config = platform_config_.output_config.datalog_config;
     if (datalog_config.output_datalog) {
-        datalog_ofstream_.open(datalog_config.path_to_output_datalog);
+        auto datalog_format = DatalogFormat::YAML;
+        if (datalog_config.datalog_format == "YAML") {
+            datalog_format = DatalogFormat::YAML;
+        } else if (datalog_config.datalog_format == "BINARY") {
+            datalog_format = DatalogFormat::BINARY;
+            datalog_frame_builder_ = DatalogFrameBuilder(datalog_config.keyframe_interval);
+        } else {
+            assert(false && "[ERROR] WRONG DATALOG FORMAT SETTING! Please check the datalog_format in config!");
+        }
+        auto datalog_compression = DatalogCompression::NONE;
+        if (datalog_config.datalog_compression == "NONE") {
+            datalog_compression = DatalogCompression::NONE;
+        } else if (datalog_config.datalog_compression == "GZIP") {
+            datalog_compression = DatalogCompression::GZIP;
+        } else if (datalog_config.datalog_compression == "ZSTD") {
+            datalog_compression = DatalogCompression::ZSTD;
+        } else {
+            assert(false &&
+                   "[ERROR] WRONG DATALOG COMPRESSION SETTING! Please check the datalog_compression in config!");
+        }
+        datalog_writer_.Open(datalog_config.path_to_output_datalog, datalog_format, datalog_compression,
+                             datalog_format == DatalogFormat::BINARY ? datalog_config.keyframe_interval : 1,
+                             datalog_config.write_in_background);
 
         fmt::print("[INFO] Opened the output datalog file at {}.\n",
                    datalog_config.path_to_output_datalog);
     }
+    // Open the output epoch metrics file and write its header.
+    const auto &profile_config = platform_config_.output_config.profile_config;
+    if (!profile_config.path_to_output_epoch_metrics.empty()) {
+        epoch_metrics_file_.open(profile_config.path_to_output_epoch_metrics);
+        assert(epoch_metrics_file_.is_open() && "[ERROR] Failed to open the output epoch metrics file!");
+        num_of_trip_size_columns_ = platform_config_.mod_system_config.fleet_config.veh_capacity + 1;
+        epoch_metrics_file_ << "epoch,system_time_s,new_orders,considered_orders";
+        for (auto k = 0; k < num_of_trip_size_columns_; k++) {
+            epoch_metrics_file_ << ",vt_pairs_k" << k << (k == num_of_trip_size_columns_ - 1 ? "+" : "");
+        }
+        epoch_metrics_file_ << ",ilp_variables,ilp_constraints";
+        for (auto i = 0; i < num_of_profiler_phases; i++) {
+            epoch_metrics_file_ << "," << ToString(static_cast<ProfilerPhase>(i)) << "_ms";
+        }
+        epoch_metrics_file_ << ",idle_vehicles,rebalancing_vehicles,cumulative_service_rate\n";
+        fmt::print("[INFO] Opened the output epoch metrics file at {}.\n", profile_config.path_to_output_epoch_metrics);
+    }
+
+    // Clear the profile of any previous simulation in this process.
+    Profiler::Global().Reset();
     fmt::print("[INFO] Platform is ready.\n");
 
 }
@@ -91,8 +143,8 @@ Platform<RouterFunc, DemandGeneratorFunc>::Platform(PlatformConfig _platform_con
 template <typename RouterFunc, typename DemandGeneratorFunc>
 Platform<RouterFunc, DemandGeneratorFunc>::~Platform() {
     // Close the datalog stream.
-    if (datalog_ofstream_.is_open()) {
-        datalog_ofstream_.close();
+    if (datalog_writer_.IsOpen()) {
+        datalog_writer_.Close();
         fmt::print("[INFO] Closed the datalog. Program ends.\n");
     }
 }
@@ -126,11 +178,21 @@ void Platform<RouterFunc, DemandGeneratorFunc>::RunSimulation(std::time_t simula
     auto main_sim_runtime_s = (main_sim_end_time_stamp - main_sim_start_time_stamp) / 1000.0;
     fmt::print("[INFO] Simulation completed. Creating report.\n");
     CreateReport(simulation_start_time_stamp, total_init_time_s, main_sim_runtime_s);
+
+    // Export the profile, if asked.
+    const auto &profile_config = platform_config_.output_config.profile_config;
+    if (!profile_config.path_to_output_profile.empty()) {
+        Profiler::Global().ExportToFile(profile_config.path_to_output_profile,
+                                        profile_config.profile_format == "JSON" ? ProfileFormat::JSON
+                                                                                : ProfileFormat::CSV);
+        fmt::print("[INFO] Exported the profile to {}.\n", profile_config.path_to_output_profile);
+    }
 };
 
 template <typename RouterFunc, typename DemandGeneratorFunc>
 void Platform<RouterFunc, DemandGeneratorFunc>::RunCycle(std::string progress_phase) {
     TIMER_START(t)
+    Profiler::Global().ResetDispatchCounters();
     if (DEBUG_PRINT) {
         fmt::print("[DEBUG] T = {}s: Epoch {}/{} is running. [{}]\n",
                    (system_time_ms_) / 1000,
@@ -146,6 +208,7 @@ void Platform<RouterFunc, DemandGeneratorFunc>::RunCycle(std::string progress_ph
             AdvanceVehicles(frame_ms_);
             if (ms < cycle_ms_ - frame_ms_ &&
                 platform_config_.output_config.datalog_config.output_datalog) {
+                if (platform_config_.simulation_config.event_driven) { SyncVehiclesToSystemTime(); }
                 WriteToDatalog();
             }
         }
@@ -153,54 +216,99 @@ void Platform<RouterFunc, DemandGeneratorFunc>::RunCycle(std::string progress_ph
         // Advance the vehicles by the whole cycle.
         AdvanceVehicles(cycle_ms_);
     }
-        // Reject the long waited orders.
-    for (auto &order : orders_) {
-        if (order.status != OrderStatus::PENDING) { continue; }
-        if (order.request_time_ms + 150 * 1000 <= system_time_ms_ || order.max_pickup_time_ms <= system_time_ms_) {
+    // Reject the long waited orders, and remove the complete and walkaway orders from the active orders.
+    auto active_order_ids_end = std::remove_if(active_order_ids_.begin(), active_order_ids_.end(), [&](size_t id) {
+        auto &order = orders_[id];
+        if (order.status == OrderStatus::PENDING && (order.request_time_ms + 150 * 1000 <= system_time_ms_ ||
+                                                     order.max_pickup_time_ms <= system_time_ms_)) {
             order.status = OrderStatus::WALKAWAY;
         }
-    }
+        if (order.status != OrderStatus::COMPLETE && order.status != OrderStatus::WALKAWAY) { return false; }
+        if (order.status == OrderStatus::COMPLETE) {
+            num_of_removed_complete_orders_++;
+        } else {
+            num_of_removed_walkaway_orders_++;
+        }
+        if (order.request_time_ms > main_sim_start_time_ms_ && order.request_time_ms <= main_sim_end_time_ms_) {
+            num_of_removed_main_sim_orders_++;
+            if (order.status == OrderStatus::COMPLETE) { num_of_removed_main_sim_complete_orders_++; }
+        }
+        return true;
+    });
+    active_order_ids_.erase(active_order_ids_end, active_order_ids_.end());
+    orders_.ArchiveOrdersBefore(order_archive_horizon_);
+    order_archive_horizon_ = active_order_ids_.empty() ? orders_.size() : active_order_ids_.front();
 
     // 2. Generate orders.
     const auto new_received_order_ids = GenerateOrders();
 
     // 3. Assign orders to vehicles.
+    //    (In event-driven mode, the vehicles are brought to the current time only if the dispatcher has orders to
+    //    assign, or at the start and end of the statistics period. Otherwise, only the idle vehicles are needed,
+    //    which are the ones considered by the rebalancer.)
+    if (platform_config_.simulation_config.event_driven) {
+        bool all_vehicles_are_needed = !new_received_order_ids.empty() ||
+                (dispatcher_ == DispatcherMethod::OSP && system_time_ms_ > main_sim_start_time_ms_ &&
+                 system_time_ms_ <= main_sim_end_time_ms_) ||
+                system_time_ms_ == main_sim_start_time_ms_ + cycle_ms_ ||
+                system_time_ms_ == main_sim_end_time_ms_ + cycle_ms_;
+        SyncVehiclesToSystemTime(!all_vehicles_are_needed);
+    }
     for (auto &vehicle : vehicles_) { vehicle.schedule_has_been_updated_at_current_epoch = false; }
     if (system_time_ms_ > main_sim_start_time_ms_ && system_time_ms_ <= main_sim_end_time_ms_) {
         if (dispatcher_ == DispatcherMethod::GI) {
             AssignOrdersThroughGreedyInsertion(
-                    new_received_order_ids, orders_, vehicles_, system_time_ms_, router_func_);
+                    new_received_order_ids, orders_, vehicles_, fleet_state_, system_time_ms_, router_func_);
         } else if (dispatcher_ == DispatcherMethod::SBA) {
-            AssignOrdersThroughSingleRequestBatchAssign(
-                    new_received_order_ids, orders_, vehicles_, system_time_ms_, router_func_);
+            AssignOrdersThroughSingleRequestBatchAssign(new_received_order_ids, orders_, vehicles_, fleet_state_,
+                                                        system_time_ms_, router_func_, ilp_solver_envs_);
         } else if (dispatcher_ == DispatcherMethod::OSP) {
-            AssignOrdersThroughOptimalSchedulePoolAssign(
-                    new_received_order_ids, orders_, vehicles_, system_time_ms_, router_func_);
+            TIMER_START(dispatch_start_time)
+            auto latency_budget_expired = AssignOrdersThroughOptimalSchedulePoolAssign(
+                    new_received_order_ids, active_order_ids_, orders_, vehicles_, fleet_state_, system_time_ms_,
+                    router_func_, ilp_solver_envs_,
+                    platform_config_.mod_system_config.dispatch_config.latency_budget_ms);
+            if (latency_budget_expired) { num_of_epochs_over_latency_budget_++; }
+            max_dispatch_time_ms_ = std::max(max_dispatch_time_ms_,
+                                             static_cast<uint64_t>(getTimeStampMs() - dispatch_start_time));
         }
     } else {
-        AssignOrdersThroughSingleRequestBatchAssign(
-                new_received_order_ids, orders_, vehicles_, system_time_ms_, router_func_);
+        AssignOrdersThroughSingleRequestBatchAssign(new_received_order_ids, orders_, vehicles_, fleet_state_,
+                                                    system_time_ms_, router_func_, ilp_solver_envs_);
     }
 
     // 4. Reposition idle vehicles to high demand areas.
     if (rebalancer_ == RebalancerMethod::RVS) {
-        RepositionIdleVehiclesToRandomVehicleStations(vehicles_, router_func_);
+        RepositionIdleVehiclesToRandomVehicleStations(vehicles_, fleet_state_, router_func_);
     } else if (rebalancer_ == RebalancerMethod::NPO) {
-        RepositionIdleVehiclesToNearestPendingOrders(orders_, vehicles_, router_func_);
+        RepositionIdleVehiclesToNearestPendingOrders(active_order_ids_, orders_, vehicles_, fleet_state_,
+                                                     router_func_);
+    }
+    if (platform_config_.simulation_config.event_driven &&
+        std::any_of(vehicles_.begin(), vehicles_.end(), [](const Vehicle &vehicle) {
+            return vehicle.schedule_has_been_updated_at_current_epoch;
+        })) {
+        RebuildVehicleEventQueue();
     }
 
     // 5. Write the datalog to file.
     if (system_time_ms_ > main_sim_start_time_ms_ && system_time_ms_ <= main_sim_end_time_ms_ &&
         platform_config_.output_config.datalog_config.output_datalog) {
-        WriteToDatalog();
+        if (platform_config_.simulation_config.event_driven) { SyncVehiclesToSystemTime(); }
+        WriteToDatalog(true);
     }
 
-    // 6. Check the statuses of orders, to make sure that no one is assigned to multiple vehicles.
+    // 6. Write the metrics of the epoch to file.
+    if (epoch_metrics_file_.is_open()) { WriteEpochMetrics(new_received_order_ids.size()); }
+
+    // 7. Check the statuses of orders, to make sure that no one is assigned to multiple vehicles.
     if (DEBUG_PRINT) {
         auto num_of_total_orders = orders_.size();
-        auto num_of_complete_orders = 0, num_of_onboard_orders = 0, num_of_picking_orders = 0,
-                num_of_pending_orders = 0, num_of_walkaway_orders = 0;
-        for (const auto &order : orders_) {
+        auto num_of_complete_orders = num_of_removed_complete_orders_, num_of_onboard_orders = 0ul,
+                num_of_picking_orders = 0ul, num_of_pending_orders = 0ul,
+                num_of_walkaway_orders = num_of_removed_walkaway_orders_;
+        for (auto order_id : active_order_ids_) {
+            const auto &order = orders_[order_id];
             if (order.status == OrderStatus::COMPLETE) {
                 num_of_complete_orders++;
             } else if (order.status == OrderStatus::ONBOARD) {
@@ -244,25 +352,33 @@ void Platform<RouterFunc, DemandGeneratorFunc>::RunCycle(std::string progress_ph
 template <typename RouterFunc, typename DemandGeneratorFunc>
 void Platform<RouterFunc, DemandGeneratorFunc>::AdvanceVehicles(uint64_t time_ms) {
 
-    TIMER_START(t)
+    ScopedPhaseTimer t(ProfilerPhase::ADVANCE);
     if (DEBUG_PRINT) {
         fmt::print("        -Updating vehicles positions and orders statues by {}s...\n", time_ms / 1000);
     }
 
-    auto num_of_picked_orders = 0;
-    auto num_of_dropped_orders = 0;
+    size_t num_of_picked_orders = 0;
+    size_t num_of_dropped_orders = 0;
 
-    // Do it for each of the vehicles independently.
-    for (auto &vehicle : vehicles_) {
-        auto [new_picked_order_ids, new_dropped_order_ids] =
-                UpdVehiclePos(vehicle,
-                              orders_,
-                              system_time_ms_,
-                              time_ms,
-                              (system_time_ms_ > main_sim_start_time_ms_ &&
-                               system_time_ms_ <= main_sim_end_time_ms_));
-        num_of_picked_orders += new_picked_order_ids.size();
-        num_of_dropped_orders += new_dropped_order_ids.size();
+    if (!platform_config_.simulation_config.event_driven) {
+        // Do it for each of the vehicles independently.
+        const bool update_vehicle_stats =
+                system_time_ms_ > main_sim_start_time_ms_ && system_time_ms_ <= main_sim_end_time_ms_;
+        std::tie(num_of_picked_orders, num_of_dropped_orders) = AdvanceEachVehicle([&](Vehicle &vehicle) {
+            return UpdVehiclePos(vehicle, fleet_state_, orders_, system_time_ms_, time_ms, update_vehicle_stats);
+        });
+    } else {
+        // Only process the events that happen within the time, in time order. Each vehicle is advanced to the time
+        // of its event, i.e., its arrival at a waypoint, where the orders are picked up or dropped off.
+        while (!vehicle_events_.empty() && vehicle_events_.top().first <= system_time_ms_ + time_ms) {
+            auto [event_time_ms, vehicle_id] = vehicle_events_.top();
+            vehicle_events_.pop();
+            auto [new_picked_order_ids, new_dropped_order_ids] =
+                    AdvanceVehicleToTime(vehicles_[vehicle_id], event_time_ms);
+            num_of_picked_orders += new_picked_order_ids.size();
+            num_of_dropped_orders += new_dropped_order_ids.size();
+            PushNextEventOfVehicle(vehicles_[vehicle_id]);
+        }
     }
 
     // Increment the system time.
@@ -283,9 +399,91 @@ void Platform<RouterFunc, DemandGeneratorFunc>::AdvanceVehicles(uint64_t time_ms
     }
 }
 
+template <typename RouterFunc, typename DemandGeneratorFunc>
+template <typename AdvanceFunc>
+std::pair<size_t, size_t> Platform<RouterFunc, DemandGeneratorFunc>::AdvanceEachVehicle(AdvanceFunc advance_func) {
+    const auto num_of_threads = vehicle_worker_pool_.getNumOfWorkers();
+    std::vector<size_t> num_of_picked_orders_of_threads(num_of_threads, 0);
+    std::vector<size_t> num_of_dropped_orders_of_threads(num_of_threads, 0);
+
+    // A vehicle only changes itself and the orders in its own schedule, so the vehicles are split into chunks
+    // advanced by the workers of the pool. Each worker counts in locals and writes its slot once, so that the workers
+    // do not contend on the cache line of the counters.
+    auto advance_chunk_of_vehicles = [&](size_t k) {
+        auto first = k * vehicles_.size() / num_of_threads;
+        auto last = (k + 1) * vehicles_.size() / num_of_threads;
+        size_t num_of_picked_orders = 0;
+        size_t num_of_dropped_orders = 0;
+        for (auto i = first; i < last; i++) {
+            auto [new_picked_order_ids, new_dropped_order_ids] = advance_func(vehicles_[i]);
+            num_of_picked_orders += new_picked_order_ids.size();
+            num_of_dropped_orders += new_dropped_order_ids.size();
+        }
+        num_of_picked_orders_of_threads[k] = num_of_picked_orders;
+        num_of_dropped_orders_of_threads[k] = num_of_dropped_orders;
+    };
+    vehicle_worker_pool_.Run(advance_chunk_of_vehicles);
+
+    return {std::accumulate(num_of_picked_orders_of_threads.begin(), num_of_picked_orders_of_threads.end(),
+                            static_cast<size_t>(0)),
+            std::accumulate(num_of_dropped_orders_of_threads.begin(), num_of_dropped_orders_of_threads.end(),
+                            static_cast<size_t>(0))};
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+std::pair<std::vector<size_t>, std::vector<size_t>>
+Platform<RouterFunc, DemandGeneratorFunc>::AdvanceVehicleToTime(Vehicle &vehicle, uint64_t time_ms) {
+    auto &updated_time_ms = vehicle_updated_time_ms_[vehicle.id];
+    assert(time_ms >= updated_time_ms);
+    // The statistics cover the same period as in the frame-by-frame mode, i.e., the cycles starting within
+    // (main_sim_start_time_ms_, main_sim_end_time_ms_]. All vehicles are synced at both ends of the period.
+    const bool update_vehicle_stats = updated_time_ms >= main_sim_start_time_ms_ + cycle_ms_ &&
+                                      updated_time_ms < main_sim_end_time_ms_ + cycle_ms_;
+    auto new_picked_and_dropped_order_ids =
+            UpdVehiclePos(vehicle, fleet_state_, orders_, updated_time_ms, time_ms - updated_time_ms,
+                          update_vehicle_stats);
+    updated_time_ms = time_ms;
+    return new_picked_and_dropped_order_ids;
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::SyncVehiclesToSystemTime(bool only_idle_vehicles) {
+    ScopedPhaseTimer t(ProfilerPhase::ADVANCE);
+    // All the events before the system time have been processed, so no order is picked up or dropped off here.
+    auto [num_of_picked_orders, num_of_dropped_orders] = AdvanceEachVehicle([&](Vehicle &vehicle) {
+        if (only_idle_vehicles && vehicle.status != VehicleStatus::IDLE) {
+            return std::pair<std::vector<size_t>, std::vector<size_t>>();
+        }
+        return AdvanceVehicleToTime(vehicle, system_time_ms_);
+    });
+    assert(num_of_picked_orders == 0 && num_of_dropped_orders == 0);
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::PushNextEventOfVehicle(const Vehicle &vehicle) {
+    uint64_t time_to_next_event_ms = 0;
+    if (vehicle.status != VehicleStatus::IDLE) {
+        time_to_next_event_ms = vehicle.schedule[0].route.duration_ms - vehicle.route_cursor.elapsed_ms;
+    } else if (vehicle.step_to_pos.duration_ms > 0) {
+        time_to_next_event_ms = vehicle.step_to_pos.duration_ms;
+    } else {
+        return;
+    }
+    // A waypoint at the vehicle's current position (zero duration) is visited 1 ms later, since a vehicle can only be
+    // advanced by a positive time. The visit is still recorded at the time of arrival.
+    vehicle_events_.emplace(vehicle_updated_time_ms_[vehicle.id] + std::max(time_to_next_event_ms,
+                                                                             static_cast<uint64_t>(1)), vehicle.id);
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::RebuildVehicleEventQueue() {
+    vehicle_events_ = {};
+    for (const auto &vehicle : vehicles_) { PushNextEventOfVehicle(vehicle); }
+}
+
 template <typename RouterFunc, typename DemandGeneratorFunc>
 std::vector<size_t> Platform<RouterFunc, DemandGeneratorFunc>::GenerateOrders() {
-    TIMER_START(t)
+    ScopedPhaseTimer t(ProfilerPhase::GENERATE);
     if (DEBUG_PRINT) {
         fmt::print("        -Loading new orders... [T = {}s]\n", (system_time_ms_) / 1000.0);
     }
@@ -300,12 +498,12 @@ std::vector<size_t> Platform<RouterFunc, DemandGeneratorFunc>::GenerateOrders()
     for (auto &request : requests) {
         Order order;
         order.id = orders_.size();
-        order.origin = router_func_.getNodePos(request.origin_node_id);
-        order.destination = router_func_.getNodePos(request.destination_node_id);
+        order.origin_node_id = request.origin_node_id;
+        order.destination_node_id = request.destination_node_id;
         order.request_time_ms = request.request_time_ms;
-        order.request_time_date = request.request_time_date;
-        order.shortest_travel_time_ms =
-                router_func_(order.origin, order.destination, RoutingType::TIME_ONLY).duration_ms;
+        order.shortest_travel_time_ms = router_func_(router_func_.getNodePos(order.origin_node_id),
+                                                     router_func_.getNodePos(order.destination_node_id),
+                                                     RoutingType::TIME_ONLY).duration_ms;
         // max_wait = min(max_pickup_wait_time, shortest_travel_time * 0.7),
         // max_total_delay = min(max_pickup_wait_time * 2, max_wait + shortest_travel_time * 0.3).
         order.max_pickup_time_ms =
@@ -318,6 +516,7 @@ std::vector<size_t> Platform<RouterFunc, DemandGeneratorFunc>::GenerateOrders()
                          order.max_pickup_time_ms - order.request_time_ms
                          + static_cast<int32_t>(order.shortest_travel_time_ms * (max_detour - 1)));
         new_received_order_ids.push_back(orders_.size());
+        active_order_ids_.push_back(orders_.size());
         assert(order.status == OrderStatus::PENDING);
         orders_.push_back(std::move(order));
 
@@ -325,9 +524,11 @@ std::vector<size_t> Platform<RouterFunc, DemandGeneratorFunc>::GenerateOrders()
 //            fmt::print("            +Order {} requested at {}s ({}), from {} to {}, Ts = {}s\n",
 //                       orders_.back().id,
 //                       orders_.back().request_time_ms / 1000,
-//                       orders_.back().request_time_date,
-//                       orders_.back().origin.node_id,
-//                       orders_.back().destination.node_id,
+//                       ConvertTimeSecondToDate(ConvertTimeDateToSeconds(
+//                               platform_config_.simulation_config.simulation_start_time) +
+//                               orders_.back().request_time_ms / 1000),
+//                       orders_.back().origin_node_id,
+//                       orders_.back().destination_node_id,
 //                       orders_.back().shortest_travel_time_ms / 1000.0 );
 //        }
 
@@ -343,68 +544,68 @@ std::vector<size_t> Platform<RouterFunc, DemandGeneratorFunc>::GenerateOrders()
 
 
 template <typename RouterFunc, typename DemandGeneratorFunc>
-void Platform<RouterFunc, DemandGeneratorFunc>::WriteToDatalog() {
-    TIMER_START(t)
+void Platform<RouterFunc, DemandGeneratorFunc>::WriteToDatalog(bool schedules_may_have_been_rebuilt) {
+    ScopedPhaseTimer t(ProfilerPhase::DATALOG);
     if (DEBUG_PRINT) {
         fmt::print("        -Writing to datalog ()...");
     }
 
-    YAML::Node node;
-    node["system_time_ms"] = system_time_ms_;
+    datalog_frame_builder_.Build(datalog_frame_, system_time_ms_, vehicles_, orders_, router_func_.getNetworkNodes(),
+                                 schedules_may_have_been_rebuilt);
+    datalog_writer_.WriteFrame(datalog_frame_);
 
-    // For each of the vehicles, we write the relevant data in yaml format.
-    for (const auto &vehicle : vehicles_) {
-        YAML::Node veh_node;
-
-        YAML::Node pos_node;
-        pos_node["lon"] = fmt::format("{:.6f}", vehicle.pos.lon);
-        pos_node["lat"] = fmt::format("{:.6f}", vehicle.pos.lat);
-        veh_node["pos"] = std::move(pos_node);
-
-        YAML::Node waypoints_node;
-        for (const auto &waypoint : vehicle.schedule) {
-            YAML::Node waypoint_node;
-            auto count = 0;
-            for (const auto &step : waypoint.route.steps) {
-                for (const auto &pose : step.poses) {
-                    YAML::Node step_node;
-                    step_node["lon"] = fmt::format("{:.6f}", pose.lon);
-                    step_node["lat"] = fmt::format("{:.6f}", pose.lat);
-                    waypoint_node.push_back(std::move(step_node));
-                }
-            }
-            waypoints_node.push_back(std::move(waypoint_node));
-        }
-        veh_node["waypoints"] = std::move(waypoints_node);
-        node["vehicles"].push_back(std::move(veh_node));
-    }
-
-    // For each of the orders, we write the relevant data in yaml format.
-    for (const auto &order : orders_) {
-        YAML::Node origin_pos_node;
-        origin_pos_node["lon"] = fmt::format("{:.6f}", order.origin.lon);
-        origin_pos_node["lat"] = fmt::format("{:.6f}", order.origin.lat);
-
-        YAML::Node destination_pos_node;
-        destination_pos_node["lon"] = fmt::format("{:.6f}", order.destination.lon);
-        destination_pos_node["lat"] = fmt::format("{:.6f}", order.destination.lat);
-
-        YAML::Node order_node;
-        order_node["id"] = order.id;
-        order_node["origin"] = std::move(origin_pos_node);
-        order_node["destination"] = std::move(destination_pos_node);
-        order_node["status"] = order_status_to_string(order.status);
-        order_node["request_time_ms"] = order.request_time_ms;
-        order_node["max_pickup_time_ms"] = order.max_pickup_time_ms;
-        order_node["pickup_time_ms"] = order.pickup_time_ms;
-        order_node["dropoff_time_ms"] = order.dropoff_time_ms;
+    if (DEBUG_PRINT) { TIMER_END(t) }
+}
 
-        node["orders"].push_back(std::move(order_node));
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::WriteEpochMetrics(size_t num_of_new_received_orders) {
+    const auto &dispatch_counters = Profiler::Global().getDispatchCounters();
+    epoch_metrics_file_ << fmt::format("{},{},{},{}", system_time_ms_ / cycle_ms_, system_time_ms_ / 1000,
+                                       num_of_new_received_orders, dispatch_counters.num_of_considered_orders);
+
+    // The vehicle-trip pairs of each trip size, the pairs of larger trips counted in the last column.
+    std::vector<size_t> num_of_vt_pairs(num_of_trip_size_columns_, 0);
+    const auto &num_of_vt_pairs_of_trip_size = dispatch_counters.num_of_vt_pairs_of_trip_size;
+    for (auto k = 0; k < num_of_vt_pairs_of_trip_size.size(); k++) {
+        num_of_vt_pairs[std::min(k, static_cast<int>(num_of_trip_size_columns_) - 1)] +=
+                num_of_vt_pairs_of_trip_size[k];
+    }
+    for (auto num : num_of_vt_pairs) { epoch_metrics_file_ << "," << num; }
+    epoch_metrics_file_ << fmt::format(",{},{}", dispatch_counters.num_of_ilp_variables,
+                                       dispatch_counters.num_of_ilp_constraints);
+
+    // The time of each phase at this epoch.
+    for (auto i = 0; i < num_of_profiler_phases; i++) {
+        auto phase_total_ns = Profiler::Global().getHistogram(static_cast<ProfilerPhase>(i)).getTotalNs();
+        epoch_metrics_file_ << fmt::format(",{:.3f}", (phase_total_ns - phase_total_ns_at_last_epoch_[i]) / 1e6);
+        phase_total_ns_at_last_epoch_[i] = phase_total_ns;
     }
 
-    datalog_ofstream_ << node << std::endl << "---\n";
+    // The vehicles' statuses after dispatching and rebalancing.
+    size_t num_of_idle_vehicles = 0;
+    size_t num_of_rebalancing_vehicles = 0;
+    for (const auto &vehicle : vehicles_) {
+        if (vehicle.status == VehicleStatus::IDLE) { num_of_idle_vehicles++; }
+        else if (vehicle.status == VehicleStatus::REBALANCING) { num_of_rebalancing_vehicles++; }
+    }
 
-    if (DEBUG_PRINT) { TIMER_END(t) }
+    // The service rate so far, as in the report, i.e. the complete and onboard orders over the orders requested in
+    // the main simulation (up to now).
+    auto num_of_main_sim_orders = num_of_removed_main_sim_orders_;
+    auto num_of_served_main_sim_orders = num_of_removed_main_sim_complete_orders_;
+    for (auto order_id : active_order_ids_) {
+        const auto &order = orders_[order_id];
+        if (order.request_time_ms <= main_sim_start_time_ms_ || order.request_time_ms > main_sim_end_time_ms_) {
+            continue;
+        }
+        num_of_main_sim_orders++;
+        if (order.status == OrderStatus::COMPLETE || order.status == OrderStatus::ONBOARD) {
+            num_of_served_main_sim_orders++;
+        }
+    }
+    epoch_metrics_file_ << fmt::format(",{},{},{:.2f}\n", num_of_idle_vehicles, num_of_rebalancing_vehicles,
+                                       num_of_main_sim_orders > 0 ?
+                                       100.0 * num_of_served_main_sim_orders / num_of_main_sim_orders : 0.0);
 }
 
 template <typename RouterFunc, typename DemandGeneratorFunc>
@@ -420,13 +621,13 @@ void Platform<RouterFunc, DemandGeneratorFunc>::CreateReport(std::time_t simulat
     fmt::print("{}\n", dividing_line);
 
     // Get the real world time when the simulation starts and ends.
-    auto simulation_start_time_real_world_date = ConvertTimeSecondToDate(simulation_start_time_stamp / 1000);
+    auto simulation_start_time_real_world_date = ConvertTimeStampToLocalDate(simulation_start_time_stamp / 1000);
     auto simulation_end_time_stamp = getTimeStampMs();
     std::string simulation_end_time_real_world_date;
     if (orders_.size() == 0) {
         simulation_end_time_real_world_date = "0000-00-00 00:00:00";
     } else {
-        simulation_end_time_real_world_date = ConvertTimeSecondToDate(simulation_end_time_stamp / 1000);
+        simulation_end_time_real_world_date = ConvertTimeStampToLocalDate(simulation_end_time_stamp / 1000);
     }
     auto total_sim_runtime_s = (simulation_end_time_stamp - simulation_start_time_stamp) / 1000.0;
 
@@ -461,6 +662,8 @@ void Platform<RouterFunc, DemandGeneratorFunc>::CreateReport(std::time_t simulat
     auto video_frames =  platform_config_.simulation_config.simulation_duration_min * 60 / frame_length_s;
     auto video_fps = platform_config_.output_config.video_config.replay_speed / frame_length_s;
     auto video_duration = video_frames / video_fps;
+    report_ = SimulationReport();
+    report_.main_sim_runtime_s = main_sim_runtime_s;
 
     // Simulation Runtime.
     fmt::print("# Simulation Runtime\n");
@@ -481,14 +684,28 @@ void Platform<RouterFunc, DemandGeneratorFunc>::CreateReport(std::time_t simulat
                platform_config_.simulation_config.warmup_duration_min * 60 / (cycle_ms_ / 1000),
                num_of_main_epochs,
                platform_config_.simulation_config.winddown_duration_min * 60 / (cycle_ms_ / 1000), num_of_epochs);
-    fmt::print("  - Order Config: density = {} ({}), max_wait = {} s. (Δt = {} s).\n",
-               platform_config_.mod_system_config.request_config.request_density,
-               taxi_data_file_name,
-               platform_config_.mod_system_config.request_config.max_pickup_wait_time_s,
-               cycle_ms_ / 1000);
+    if (platform_config_.mod_system_config.request_config.demand_generator == "SYNTHETIC") {
+        fmt::print("  - Order Config: synthetic scale = {} ({}, seed = {}), max_wait = {} s. (Δt = {} s).\n",
+                   platform_config_.mod_system_config.request_config.demand_scale,
+                   taxi_data_file_name,
+                   platform_config_.mod_system_config.request_config.random_seed,
+                   platform_config_.mod_system_config.request_config.max_pickup_wait_time_s,
+                   cycle_ms_ / 1000);
+    } else {
+        fmt::print("  - Order Config: density = {} ({}), max_wait = {} s. (Δt = {} s).\n",
+                   platform_config_.mod_system_config.request_config.request_density,
+                   taxi_data_file_name,
+                   platform_config_.mod_system_config.request_config.max_pickup_wait_time_s,
+                   cycle_ms_ / 1000);
+    }
     fmt::print("  - Dispatch Config: dispatcher = {}, rebalancer = {}.\n",
                platform_config_.mod_system_config.dispatch_config.dispatcher,
                platform_config_.mod_system_config.dispatch_config.rebalancer);
+    if (platform_config_.mod_system_config.dispatch_config.latency_budget_ms > 0) {
+        fmt::print("  - Latency Budget: {} s, exceeded at {}/{} epochs (max_dispatch_time = {:.2f} s).\n",
+                   platform_config_.mod_system_config.dispatch_config.latency_budget_ms / 1000.0,
+                   num_of_epochs_over_latency_budget_, num_of_main_epochs, max_dispatch_time_ms_ / 1000.0);
+    }
     fmt::print("  - Video Config: {}, frame_length = {} s, fps = {}, duration = {} s.\n",
                platform_config_.output_config.video_config.render_video,
                frame_length_s, video_fps, video_duration);
@@ -509,9 +726,11 @@ void Platform<RouterFunc, DemandGeneratorFunc>::CreateReport(std::time_t simulat
     uint64_t total_delay_time_ms = 0;
     uint64_t total_order_time_ms = 0;
 
-    for (const auto &order : orders_) {
-        if (order.request_time_ms <= main_sim_start_time_ms_) { continue; }
-        if (order.request_time_ms > main_sim_end_time_ms_) { break; }
+    // (The archived orders are read back from the cold store.)
+    orders_.ForEachOrder([&](const Order &order) {
+        if (order.request_time_ms <= main_sim_start_time_ms_ || order.request_time_ms > main_sim_end_time_ms_) {
+            return;
+        }
         order_count++;
         if (order.status == OrderStatus::WALKAWAY) {
             walkaway_order_count++;
@@ -527,9 +746,14 @@ void Platform<RouterFunc, DemandGeneratorFunc>::CreateReport(std::time_t simulat
         } else if (order.status == OrderStatus::PENDING) {
             pending_order_count++;
         }
-    }
+    });
 
     auto service_order_count = complete_order_count + onboard_order_count;
+    report_.num_of_orders = order_count;
+    report_.num_of_walkaway_orders = walkaway_order_count;
+    report_.num_of_complete_orders = complete_order_count;
+    report_.num_of_onboard_orders = onboard_order_count;
+    report_.service_rate = 100.0 * service_order_count / order_count;
     assert(service_order_count + picking_order_count + pending_order_count == order_count - walkaway_order_count);
     fmt::print("# Orders ({}/{})\n", order_count - walkaway_order_count, order_count);
     fmt::print("  - complete = {} ({:.2f}%), onboard = {} ({:.2f}%), total_service = {} ({:.2f}%).\n",
@@ -542,6 +766,9 @@ void Platform<RouterFunc, DemandGeneratorFunc>::CreateReport(std::time_t simulat
                    pending_order_count, 100.0 * pending_order_count / order_count);
     }
     if (complete_order_count > 0) {
+        report_.avg_shortest_travel_s = total_order_time_ms / 1000.0 / complete_order_count;
+        report_.avg_wait_s = total_wait_time_ms / 1000.0 / complete_order_count;
+        report_.avg_delay_s = total_delay_time_ms / 1000.0 / complete_order_count;
         fmt::print("  - avg_shortest_travel = {:.2f} s, avg_wait = {:.2f} s, avg_delay = {:.2f} s.\n",
                    total_order_time_ms / 1000.0 / complete_order_count,
                    total_wait_time_ms / 1000.0 / complete_order_count,
@@ -577,6 +804,11 @@ void Platform<RouterFunc, DemandGeneratorFunc>::CreateReport(std::time_t simulat
     auto avg_time_traveled_s = total_time_traveled_ms / 1000.0 / vehicles_.size();
     auto avg_empty_time_traveled_s = total_empty_time_traveled_ms / 1000.0 / vehicles_.size();
     auto avg_rebl_time_traveled_s = total_rebl_time_traveled_ms / 1000.0 / vehicles_.size();
+    report_.total_dist_km = total_dist_traveled_mm / 1000000.0;
+    report_.avg_dist_km = avg_dist_traveled_km;
+    report_.empty_dist_rate = 100.0 * avg_empty_dist_traveled_km / avg_dist_traveled_km;
+    report_.rebl_dist_rate = 100.0 * avg_rebl_dist_traveled_km / avg_dist_traveled_km;
+    report_.avg_load_dist = total_loaded_dist_traveled_mm * 1.0 / total_dist_traveled_mm;
     fmt::print("# Vehicles ({})\n", vehicles_.size());
     fmt::print("  - Travel Distance: total_dist = {:.2f} km, avg_dist = {:.2f} km.\n",
                total_dist_traveled_mm / 1000000.0, avg_dist_traveled_km);
@@ -593,5 +825,16 @@ void Platform<RouterFunc, DemandGeneratorFunc>::CreateReport(std::time_t simulat
                total_loaded_dist_traveled_mm * 1.0 / total_dist_traveled_mm,
                total_loaded_time_traveled_ms * 1.0 / total_time_traveled_ms);
 
+    // Report the latency of each phase (all epochs), skipping the phases not run.
+    fmt::print("# Profile (p50 / p95 / p99 per call)\n");
+    for (auto i = 0; i < num_of_profiler_phases; i++) {
+        const auto &histogram = Profiler::Global().getHistogram(static_cast<ProfilerPhase>(i));
+        if (histogram.getCount() == 0) { continue; }
+        fmt::print("  - {}: calls = {}, total = {:.2f} s, latency = {:.3f} / {:.3f} / {:.3f} ms (max {:.3f} ms).\n",
+                   ToString(static_cast<ProfilerPhase>(i)), histogram.getCount(), histogram.getTotalNs() / 1e9,
+                   histogram.getPercentileNs(50) / 1e6, histogram.getPercentileNs(95) / 1e6,
+                   histogram.getPercentileNs(99) / 1e6, histogram.getMaxNs() / 1e6);
+    }
+
     fmt::print("{}\n", dividing_line);
 }
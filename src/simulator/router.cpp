@@ -9,18 +9,147 @@
 
 #include <algorithm>
 #include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#ifdef AMOD_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+#ifdef AMOD_X86_SIMD
+/// \brief The AVX2 kernel of Router::GatherTravelTimesMsToNode(), gathering 8 table cells at a time.
+/// \details The cell of origin node onid is at cells[onid * stride + offset], computed in int32, which the caller
+/// guarantees not to overflow. The seconds are converted to ms as in the scalar code, i.e. a float multiply and
+/// truncation.
+AMOD_TARGET_AVX2 void GatherTravelTimesMsToNodeAvx2(const float *cells,
+                                                    int32_t stride,
+                                                    int32_t offset,
+                                                    const uint32_t *origin_node_ids,
+                                                    size_t num_of_origins,
+                                                    int32_t *travel_times_ms) {
+    const auto strides = _mm256_set1_epi32(stride);
+    const auto offsets = _mm256_set1_epi32(offset);
+    const auto ms_per_s = _mm256_set1_ps(1000.0f);
+    size_t i = 0;
+    for (; i + 8 <= num_of_origins; i += 8) {
+        auto onids = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(origin_node_ids + i));
+        auto indices = _mm256_add_epi32(_mm256_mullo_epi32(onids, strides), offsets);
+        auto travel_times_s = _mm256_i32gather_ps(cells, indices, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(travel_times_ms + i),
+                            _mm256_cvttps_epi32(_mm256_mul_ps(travel_times_s, ms_per_s)));
+    }
+    for (; i < num_of_origins; i++) {
+        travel_times_ms[i] = cells[static_cast<int32_t>(origin_node_ids[i]) * stride + offset] * 1000;
+    }
+}
+
+/// \brief The AVX2 kernel of Router::GatherTravelTimesMsToNode() for a quantized table.
+/// \details Each uint16 cell is gathered as the lower half of a 32-bit load (the table has a padding cell at its end)
+/// and decoded as in TravelTable::operator[], i.e. quantized_cell * scale.
+AMOD_TARGET_AVX2 void GatherQuantizedTravelTimesMsToNodeAvx2(const uint16_t *quantized_cells,
+                                                             float scale,
+                                                             int32_t stride,
+                                                             int32_t offset,
+                                                             const uint32_t *origin_node_ids,
+                                                             size_t num_of_origins,
+                                                             int32_t *travel_times_ms) {
+    const auto strides = _mm256_set1_epi32(stride);
+    const auto offsets = _mm256_set1_epi32(offset);
+    const auto lower_half = _mm256_set1_epi32(0xFFFF);
+    const auto scales = _mm256_set1_ps(scale);
+    const auto ms_per_s = _mm256_set1_ps(1000.0f);
+    size_t i = 0;
+    for (; i + 8 <= num_of_origins; i += 8) {
+        auto onids = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(origin_node_ids + i));
+        auto indices = _mm256_add_epi32(_mm256_mullo_epi32(onids, strides), offsets);
+        auto quantized_travel_times = _mm256_and_si256(
+                _mm256_i32gather_epi32(reinterpret_cast<const int *>(quantized_cells), indices, 2), lower_half);
+        auto travel_times_s = _mm256_mul_ps(_mm256_cvtepi32_ps(quantized_travel_times), scales);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(travel_times_ms + i),
+                            _mm256_cvttps_epi32(_mm256_mul_ps(travel_times_s, ms_per_s)));
+    }
+    for (; i < num_of_origins; i++) {
+        travel_times_ms[i] = quantized_cells[static_cast<int32_t>(origin_node_ids[i]) * stride + offset] * scale * 1000;
+    }
+}
+#endif
+
+/// \brief Transpose a num_of_nodes x num_of_nodes table.
+TravelTable TransposeTravelTable(const TravelTable &table, size_t num_of_nodes) {
+    auto transposed_table = table;
+    for (size_t i = 0; i < num_of_nodes; i++) {
+        for (size_t j = 0; j < num_of_nodes; j++) {
+            if (table.IsQuantized()) {
+                transposed_table.quantized_cells[j * num_of_nodes + i] = table.quantized_cells[i * num_of_nodes + j];
+            } else {
+                transposed_table.cells[j * num_of_nodes + i] = table.cells[i * num_of_nodes + j];
+            }
+        }
+    }
+    return transposed_table;
+}
+
+/// \brief Quantize the float cells of the table to uint16 and record the max rounding error.
+/// \details Integral cells up to 65535 (e.g. seconds or meters within a city) are kept exactly with a scale of 1.
+/// Otherwise, the range from 0 to the max cell is split into 65535 steps, and the error of a cell is at most half a
+/// step (plus 1 ms/mm due to the truncation after "* 1000").
+void QuantizeTravelTable(TravelTable &table) {
+    assert(!table.IsQuantized());
+    float max_cell = 0;
+    bool all_cells_are_integral = true;
+    for (auto cell : table.cells) {
+        assert(std::isfinite(cell) && cell >= 0 && "The travel table can not be quantized with such a cell!");
+        max_cell = std::max(max_cell, cell);
+        all_cells_are_integral = all_cells_are_integral && cell == std::floor(cell);
+    }
+    table.scale = (max_cell == 0 || (all_cells_are_integral && max_cell <= UINT16_MAX)) ? 1.0f : max_cell / UINT16_MAX;
+
+    table.quantized_cells.assign(table.cells.size() + 1, 0);
+    table.max_error_x1000 = 0;
+    for (size_t i = 0; i < table.cells.size(); i++) {
+        auto quantized_cell = std::min(std::lround(table.cells[i] / table.scale), static_cast<long>(UINT16_MAX));
+        table.quantized_cells[i] = quantized_cell;
+        int32_t error_x1000 = std::abs(static_cast<int32_t>(table.quantized_cells[i] * table.scale * 1000) -
+                                       static_cast<int32_t>(table.cells[i] * 1000));
+        table.max_error_x1000 = std::max(table.max_error_x1000, error_x1000);
+    }
+    std::vector<float>().swap(table.cells);
+}
+}  // namespace
 
 Router::Router(std::string _path_to_network_nodes,
                std::string _path_to_vehicle_stations,
                std::string _path_to_shortest_path_table,
                std::string _path_to_mean_travel_time_table,
-               std::string _path_to_travel_distance_table) {
+               std::string _path_to_travel_distance_table,
+               bool _hold_transposed_travel_time_table,
+               bool _quantize_travel_tables) {
     TIMER_START(t)
     network_nodes_ = LoadNetworkNodesFromCsvFile(_path_to_network_nodes);
     vehicle_stations_ = LoadNetworkNodesFromCsvFile(_path_to_vehicle_stations);
     shortest_path_table_ = LoadShortestPathTableFromCsvFile(_path_to_shortest_path_table);
-    mean_travel_time_table_ = LoadMeanTravelTimeTableFromCsvFile(_path_to_mean_travel_time_table);
-    travel_distance_table_ = LoadMeanTravelTimeTableFromCsvFile(_path_to_travel_distance_table);
+    mean_travel_time_table_.cells = LoadMeanTravelTimeTableFromCsvFile(_path_to_mean_travel_time_table);
+    travel_distance_table_.cells = LoadMeanTravelTimeTableFromCsvFile(_path_to_travel_distance_table);
+    num_of_nodes_ = network_nodes_.size();
+    assert(mean_travel_time_table_.cells.size() == num_of_nodes_ * num_of_nodes_ &&
+           travel_distance_table_.cells.size() == num_of_nodes_ * num_of_nodes_ &&
+           "The travel time/distance tables do not match the network nodes!");
+    if (_quantize_travel_tables) {
+        auto float_tables_size_in_bytes = mean_travel_time_table_.SizeInBytes() + travel_distance_table_.SizeInBytes();
+        QuantizeTravelTable(mean_travel_time_table_);
+        QuantizeTravelTable(travel_distance_table_);
+        fmt::print("[INFO] Router quantized the travel time/distance tables to 16 bits: memory {:.2f} MB -> {:.2f} MB, "
+                   "max rounding error = {} ms / {} mm.\n",
+                   float_tables_size_in_bytes / 1e6,
+                   (mean_travel_time_table_.SizeInBytes() + travel_distance_table_.SizeInBytes()) / 1e6,
+                   mean_travel_time_table_.max_error_x1000, travel_distance_table_.max_error_x1000);
+    }
+    if (_hold_transposed_travel_time_table) {
+        transposed_mean_travel_time_table_ = TransposeTravelTable(mean_travel_time_table_, num_of_nodes_);
+        ReportTransposedTravelTimeTableTradeOff();
+    }
     fmt::print("[INFO] Router is ready.");
     TIMER_END(t)
 }
@@ -32,8 +161,8 @@ Route Router::operator()(const Pos &origin, const Pos &destination, RoutingType
     auto dnid = destination.node_id;
 
     if (type == RoutingType::TIME_ONLY) {
-        route.distance_mm = travel_distance_table_[onid - 1][dnid - 1] * 1000;
-        route.duration_ms = mean_travel_time_table_[onid - 1][dnid - 1] * 1000;
+        route.distance_mm = travel_distance_table_[(onid - 1) * num_of_nodes_ + dnid - 1] * 1000;
+        route.duration_ms = mean_travel_time_table_[(onid - 1) * num_of_nodes_ + dnid - 1] * 1000;
     }
 
     if (type == RoutingType::FULL_ROUTE) {
@@ -53,10 +182,12 @@ Route Router::operator()(const Pos &origin, const Pos &destination, RoutingType
             Step step;
             size_t u = path[i];
             size_t v = path[i + 1];
-            step.distance_mm = travel_distance_table_[u - 1][v - 1] * 1000;
-            step.duration_ms = mean_travel_time_table_[u - 1][v - 1] * 1000;
+            step.distance_mm = travel_distance_table_[(u - 1) * num_of_nodes_ + v - 1] * 1000;
+            step.duration_ms = mean_travel_time_table_[(u - 1) * num_of_nodes_ + v - 1] * 1000;
             step.poses.push_back(getNodePos(u));
             step.poses.push_back(getNodePos(v));
+            route.accumulated_duration_ms.push_back(route.duration_ms);
+            route.accumulated_distance_mm.push_back(route.distance_mm);
             route.distance_mm += step.distance_mm;
             route.duration_ms += step.duration_ms;
             route.steps.push_back(step);
@@ -68,14 +199,18 @@ Route Router::operator()(const Pos &origin, const Pos &destination, RoutingType
         flag_step.duration_ms = 0;
         flag_step.poses.push_back(getNodePos(dnid));
         flag_step.poses.push_back(getNodePos(dnid));
+        route.accumulated_duration_ms.push_back(route.duration_ms);
+        route.accumulated_distance_mm.push_back(route.distance_mm);
         route.steps.push_back(flag_step);
 
-        // Check the accuracy of routing.
+        // Check the accuracy of routing. (With quantized tables, each of the steps and the O/D cell may also be off
+        // by the max rounding error.)
         int deviation_due_to_data_structure = 5;
-        assert(abs(route.duration_ms - mean_travel_time_table_[onid - 1][dnid - 1] * 1000)
-               <= deviation_due_to_data_structure);
-        assert(abs(route.distance_mm - travel_distance_table_[onid - 1][dnid - 1] * 1000)
-               <= deviation_due_to_data_structure);
+        int num_of_cells = route.steps.size();
+        assert(abs(route.duration_ms - mean_travel_time_table_[(onid - 1) * num_of_nodes_ + dnid - 1] * 1000)
+               <= deviation_due_to_data_structure + num_of_cells * mean_travel_time_table_.max_error_x1000);
+        assert(abs(route.distance_mm - travel_distance_table_[(onid - 1) * num_of_nodes_ + dnid - 1] * 1000)
+               <= deviation_due_to_data_structure + num_of_cells * travel_distance_table_.max_error_x1000);
     }
 
     assert(route.duration_ms >= 0);
@@ -95,6 +230,100 @@ Pos Router::getNodePos(const size_t &node_id) {
     return network_nodes_[node_id - 1];
 }
 
+int32_t Router::getTravelTimeMs(size_t origin_node_id, size_t destination_node_id) const {
+    return mean_travel_time_table_[(origin_node_id - 1) * num_of_nodes_ + destination_node_id - 1] * 1000;
+}
+
+void Router::getTravelTimesMsToNode(const std::vector<uint32_t> &origin_node_ids,
+                                    size_t destination_node_id,
+                                    std::vector<int32_t> &travel_times_ms) const {
+    GatherTravelTimesMsToNode(origin_node_ids, destination_node_id,
+                              transposed_mean_travel_time_table_.SizeInBytes() > 0, travel_times_ms);
+}
+
+void Router::GatherTravelTimesMsToNode(const std::vector<uint32_t> &origin_node_ids,
+                                       size_t destination_node_id,
+                                       bool from_transposed_table,
+                                       std::vector<int32_t> &travel_times_ms) const {
+    travel_times_ms.resize(origin_node_ids.size());
+
+    // The cell of origin node onid is at row_start + onid * stride + offset. It is in the column of the destination
+    // node in the row-major table, or in its row in the transposed table (so the cells are close to each other).
+    const auto &table = from_transposed_table ? transposed_mean_travel_time_table_ : mean_travel_time_table_;
+    int64_t row_start = 0;
+    int64_t stride = num_of_nodes_;
+    int64_t offset = static_cast<int64_t>(destination_node_id) - 1 - static_cast<int64_t>(num_of_nodes_);
+    if (from_transposed_table) {
+        row_start = (destination_node_id - 1) * num_of_nodes_;
+        stride = 1;
+        offset = -1;
+    }
+
+#ifdef AMOD_X86_SIMD
+    // The int32 cell indices of the gather do not overflow for up to 46340 nodes.
+    if (CpuSupportsAvx2() && num_of_nodes_ * num_of_nodes_ <= INT32_MAX) {
+        if (table.IsQuantized()) {
+            GatherQuantizedTravelTimesMsToNodeAvx2(table.quantized_cells.data() + row_start, table.scale, stride,
+                                                   offset, origin_node_ids.data(), origin_node_ids.size(),
+                                                   travel_times_ms.data());
+        } else {
+            GatherTravelTimesMsToNodeAvx2(table.cells.data() + row_start, stride, offset, origin_node_ids.data(),
+                                          origin_node_ids.size(), travel_times_ms.data());
+        }
+        return;
+    }
+#endif
+    for (size_t i = 0; i < origin_node_ids.size(); i++) {
+        travel_times_ms[i] = table[row_start + origin_node_ids[i] * stride + offset] * 1000;
+    }
+}
+
+void Router::ReportTransposedTravelTimeTableTradeOff() const {
+    // Time the lookups from random origins to random destinations, which are done in batches of the fleet size
+    // when dispatching, from both tables.
+    const size_t num_of_origins = 4096;
+    const size_t num_of_destinations = 256;
+    std::mt19937 rng(0);
+    std::vector<uint32_t> origin_node_ids(num_of_origins);
+    for (auto &origin_node_id : origin_node_ids) { origin_node_id = rng() % num_of_nodes_ + 1; }
+    std::vector<size_t> destination_node_ids(num_of_destinations);
+    for (auto &destination_node_id : destination_node_ids) { destination_node_id = rng() % num_of_nodes_ + 1; }
+    std::vector<int32_t> travel_times_ms;
+    double ns_per_lookup[2];
+    for (auto from_transposed_table : {false, true}) {
+        auto start_time = std::chrono::steady_clock::now();
+        for (auto destination_node_id : destination_node_ids) {
+            GatherTravelTimesMsToNode(origin_node_ids, destination_node_id, from_transposed_table, travel_times_ms);
+        }
+        ns_per_lookup[from_transposed_table] =
+                std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count()
+                / (num_of_origins * num_of_destinations);
+    }
+
+    fmt::print("[INFO] Router holds a transposed travel time table: memory {:.2f} MB -> {:.2f} MB, "
+               "all-to-one lookups {:.2f} ns -> {:.2f} ns.\n",
+               mean_travel_time_table_.SizeInBytes() / 1e6,
+               (mean_travel_time_table_.SizeInBytes() + transposed_mean_travel_time_table_.SizeInBytes()) / 1e6,
+               ns_per_lookup[0], ns_per_lookup[1]);
+}
+
+const std::vector<Pos> &Router::getNetworkNodes() const {
+    return network_nodes_;
+}
+
+std::vector<std::vector<size_t>> Router::getNeighbouringNodes(float max_travel_time_s) {
+    std::vector<std::vector<size_t>> neighbouring_nodes(network_nodes_.size() + 1);
+    for (auto i = 0; i < network_nodes_.size(); i++) {
+        for (auto j = 0; j < network_nodes_.size(); j++) {
+            if (i != j && mean_travel_time_table_[i * num_of_nodes_ + j] <= max_travel_time_s &&
+                mean_travel_time_table_[j * num_of_nodes_ + i] <= max_travel_time_s) {
+                neighbouring_nodes[i + 1].push_back(j + 1);
+            }
+        }
+    }
+    return neighbouring_nodes;
+}
+
 std::vector<Pos> LoadNetworkNodesFromCsvFile(std::string path_to_csv) {
     CheckFileExistence(path_to_csv);
     std::vector<Pos> all_nodes;
@@ -139,22 +368,20 @@ std::vector<std::vector<int>> LoadShortestPathTableFromCsvFile(std::string path_
     return std::move(shortest_path_table);
 }
 
-std::vector<std::vector<float>> LoadMeanTravelTimeTableFromCsvFile(std::string path_to_csv) {
+std::vector<float> LoadMeanTravelTimeTableFromCsvFile(std::string path_to_csv) {
     CheckFileExistence(path_to_csv);
-    std::vector<std::vector<float>> mean_travel_time_table;
+    std::vector<float> mean_travel_time_table;
     csv::CSVReader csv_reader(path_to_csv);
     for (csv::CSVRow &row: csv_reader) {         // input iterator
-        std::vector<float> float_row;
-        float_row.reserve(row.size());
+        if (mean_travel_time_table.empty()) { mean_travel_time_table.reserve((row.size() - 1) * (row.size() - 1)); }
         long i = 0;
         for (csv::CSVField &field: row) {
             if (i == 0) {
                 i++;
                 continue;
             }
-            float_row.push_back(field.get<float>());
+            mean_travel_time_table.push_back(field.get<float>());
         }
-        mean_travel_time_table.push_back(float_row);
     }
 
     return std::move(mean_travel_time_table);
@@ -8,15 +8,34 @@
 #include "utility/utility_functions.hpp"
 #include "utility/csv.hpp"
 
+/// \brief A precomputed num_of_nodes x num_of_nodes look-up table, flattened in row-major order. The cells are stored
+/// as floats, or quantized to uint16 where the value of a cell is quantized_cells[idx] * scale.
+struct TravelTable {
+    std::vector<float> cells;               // the float cells, empty if quantized
+    std::vector<uint16_t> quantized_cells;  // the quantized cells plus a padding cell (for 32-bit gathers), or empty
+    float scale = 1.0;                      // the value of a quantization step
+    int32_t max_error_x1000 = 0;            // the max rounding error of a cell in ms (or mm), after "* 1000"
+
+    bool IsQuantized() const { return !quantized_cells.empty(); }
+    size_t SizeInBytes() const { return cells.size() * sizeof(float) + quantized_cells.size() * sizeof(uint16_t); }
+    float operator[](size_t idx) const { return IsQuantized() ? quantized_cells[idx] * scale : cells[idx]; }
+};
+
 /// \brief Stateful functor that finds the shortest route for an O/D pair on request.
 class Router {
   public:
     /// \brief Constructor.
+    /// \param _hold_transposed_travel_time_table true if a transposed copy of the travel time table is also held, for
+    /// the batched lookups from many origins to one destination. Its memory/speed trade-off is reported at startup.
+    /// \param _quantize_travel_tables true if the travel time and distance tables are quantized to uint16, halving
+    /// their memory. The max rounding error is reported at startup.
     explicit Router(std::string _path_to_network_nodes,
                     std::string _path_to_vehicle_stations,
                     std::string _path_to_shortest_path_table,
                     std::string _path_to_mean_travel_time_table,
-                    std::string _path_to_travel_distance_table);
+                    std::string _path_to_travel_distance_table,
+                    bool _hold_transposed_travel_time_table = false,
+                    bool _quantize_travel_tables = false);
 
     /// \brief Main functor that finds the shortest route for an O/D pair on request.
     Route operator()(const Pos &origin, const Pos &destination, RoutingType type);
@@ -30,7 +49,34 @@ class Router {
     /// \brief Get the pos of a node.
     Pos getNodePos(const size_t &node_id);
 
+    /// \brief Get the travel time between two nodes, the same as the duration of their TIME_ONLY route.
+    int32_t getTravelTimeMs(size_t origin_node_id, size_t destination_node_id) const;
+
+    /// \brief Get the travel times from each of the origin nodes to the destination node in a batch, the same as
+    /// calling getTravelTimeMs() for each of them. The table cells are gathered with AVX2 if the CPU supports it,
+    /// from the transposed table if it is held.
+    void getTravelTimesMsToNode(const std::vector<uint32_t> &origin_node_ids,
+                                size_t destination_node_id,
+                                std::vector<int32_t> &travel_times_ms) const;
+
+    /// \brief Get the poses of all nodes, where the pos of node_id is at index node_id - 1.
+    const std::vector<Pos> &getNetworkNodes() const;
+
+    /// \brief Get the neighbouring nodes of each node, i.e. the other nodes within max_travel_time_s of travel time
+    /// (in both directions). The result is indexed by node_id.
+    std::vector<std::vector<size_t>> getNeighbouringNodes(float max_travel_time_s);
+
 private:
+    /// \brief Gather the travel times from the origin nodes to the destination node, from the row-major table or the
+    /// transposed one.
+    void GatherTravelTimesMsToNode(const std::vector<uint32_t> &origin_node_ids,
+                                   size_t destination_node_id,
+                                   bool from_transposed_table,
+                                   std::vector<int32_t> &travel_times_ms) const;
+
+    /// \brief Print the extra memory of the transposed travel time table and the lookup times with and without it.
+    void ReportTransposedTravelTimeTableTradeOff() const;
+
     /// \brief The station node where vehicles are initially placed.
     std::vector<Pos> vehicle_stations_;
 
@@ -42,11 +88,20 @@ private:
     /// Note: Using "int" instead of "size_t" is because that some value in the shortest_path_table is -1.
     std::vector<std::vector<int>> shortest_path_table_;
 
-    /// \brief The precomputed look-up table, storing the mean travel time between each road node pair.
-    std::vector<std::vector<float>> mean_travel_time_table_;
+    /// \brief The number of road nodes, i.e. the size of a row in the tables below.
+    size_t num_of_nodes_ = 0;
+
+    /// \brief The precomputed look-up table, storing the mean travel time (s) between each road node pair.
+    /// Note: it is flattened in row-major order, i.e. the cell of (onid, dnid) is at index
+    /// (onid - 1) * num_of_nodes_ + dnid - 1, so that a batch of cells can be gathered by their indices.
+    TravelTable mean_travel_time_table_;
+
+    /// \brief The transposed copy of mean_travel_time_table_, i.e. the cell of (onid, dnid) is at index
+    /// (dnid - 1) * num_of_nodes_ + onid - 1. Empty if it is not held.
+    TravelTable transposed_mean_travel_time_table_;
 
-    /// \brief The precomputed look-up table, storing the travel distance between each road node pair.
-    std::vector<std::vector<float>> travel_distance_table_;
+    /// \brief The precomputed look-up table, storing the travel distance (m) between each road node pair (row-major).
+    TravelTable travel_distance_table_;
 };
 
 /// \brief A function loading the road network node data from a csv file.
@@ -55,5 +110,6 @@ std::vector<Pos> LoadNetworkNodesFromCsvFile(std::string path_to_csv);
 /// \brief A function loading the precomputed minimum mean travel time path of each node pair from a csv file.
 std::vector<std::vector<int>> LoadShortestPathTableFromCsvFile(std::string path_to_csv);
 
-/// \brief A function loading the precomputed mean travel time of each node pair from a csv file.
-std::vector<std::vector<float>> LoadMeanTravelTimeTableFromCsvFile(std::string path_to_csv);
+/// \brief A function loading the precomputed mean travel time of each node pair from a csv file, flattened in
+/// row-major order.
+std::vector<float> LoadMeanTravelTimeTableFromCsvFile(std::string path_to_csv);
@@ -42,6 +42,15 @@ struct Route {
     int32_t duration_ms = 0;
     //The last step of a route is always consisting of 2 identical points as a flag of the end of the leg.
     std::vector<Step> steps;
+    // The accumulated duration/distance from the start of the route to the start of each step (full route only).
+    std::vector<int32_t> accumulated_duration_ms;
+    std::vector<int32_t> accumulated_distance_mm;
+};
+
+/// \brief The progress of a vehicle on a route. The route itself is kept unchanged while the vehicle moves on it.
+struct RouteCursor {
+    size_t step_idx = 0;      // the index of the step that the vehicle is currently on
+    int32_t elapsed_ms = 0;   // the time elapsed since the start of the route
 };
 
 /// \brief The type of the routing call.
@@ -56,17 +65,16 @@ enum class RoutingType {
 
 /// \brief The order request generated by the demand generator.
 /// \param request_time_ms The request sent time relative to the start of the simulation, starting from 0.
-/// \param request_time_date The request sent time, same as recorded in the real word.
-/// note: request_time_ms = request_time_date - simulation_start_time_date
+/// note: the request sent time recorded in the real word is simulation_start_time + request_time_ms, which is only
+/// formatted as a date when it is displayed.
 struct Request {
   size_t origin_node_id;
   size_t destination_node_id;
   uint64_t request_time_ms;
-  std::string request_time_date = "0000-00-00 00:00:00";
 };
 
 /// \brief The status of the order.
-enum class OrderStatus {
+enum class OrderStatus : uint8_t {
     PENDING,     // the order has been generated by the demand generator and is currently in the waiting queue
     PICKING,     // the order has been assigned a vehicle and will be picked up later
     ONBOARD,     // the order has been picked up and is currently onboard
@@ -91,22 +99,24 @@ inline std::string order_status_to_string(const OrderStatus &s) {
 }
 
 /// \brief The order that the simulation managed, containing all relavant data.
+/// \details The order is kept compact (40 bytes), as the orders of the whole simulation stay in memory: the origin and
+/// destination are node ids, whose poses are given by the router (getNodePos), and the times are integers.
 /// \param request_time_ms Same as the definition in Request.
-/// \param request_time_date Same as the definition in Request.
 struct Order {
-    size_t id;  // Note: the order id starts from 0, equaling to its idx.
-    Pos origin;
-    Pos destination;
-    OrderStatus status = OrderStatus::PENDING;
+    uint32_t id;  // Note: the order id starts from 0, equaling to its idx.
+    uint32_t origin_node_id;
+    uint32_t destination_node_id;
     int32_t request_time_ms = 0;
-    std::string request_time_date = "0000-00-00 00:00:00";
     int32_t shortest_travel_time_ms = 0;
     int32_t max_pickup_time_ms = 0;
     int32_t max_dropoff_time_ms = 0;
     int32_t pickup_time_ms = 0;
     int32_t dropoff_time_ms = 0;
+    OrderStatus status = OrderStatus::PENDING;
 };
 
+static_assert(sizeof(Order) == 40, "Unexpected padding in Order!");
+
 //////////////////////////////////////////////////////////////////////////////////////////////////
 /// Vehicle Types
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -127,7 +137,7 @@ struct Waypoint {
 };
 
 /// \brief The operation associated with a waypoint.
-enum class VehicleStatus {
+enum class VehicleStatus : uint8_t {
     IDLE,          // the vehicle has no task and stays stationary
     WORKING,       // the vehicle is serving orders
     REBALANCING    // the vehicle is moving towards a reposition location to improve future performance
@@ -153,6 +163,7 @@ struct Vehicle {
     bool schedule_has_been_updated_at_current_epoch = false; // false at the start of each epoch,
     // true if vehicle's schedule is rebuilt. Only used in func UpdScheduleForVehiclesHavingOrdersRemoved().
     Step step_to_pos;
+    RouteCursor route_cursor; // the progress on the route of the first waypoint in the schedule
     size_t capacity = 1;
     size_t load = 0;
     std::vector<Waypoint> schedule;
@@ -169,6 +180,18 @@ struct Vehicle {
     // 10 s picking (no passenger onboard) and 80 s travelling with passenger onboard.
 };
 
+/// \brief The hot fields of all vehicles in the structure-of-arrays layout, indexed by vehicle id.
+/// \details It mirrors the few fields read by the fleet-wide filters (e.g. the quick check of an order against all
+/// vehicles), so that they run as tight loops over contiguous arrays instead of striding through the Vehicle structs.
+/// It is kept in sync by UpdVehiclePos() and UpdVehicleScheduleAndBuildRoute().
+struct FleetState {
+    std::vector<uint32_t> node_ids;                  // vehicle.pos.node_id
+    std::vector<int32_t> step_to_pos_durations_ms;   // vehicle.step_to_pos.duration_ms
+    std::vector<VehicleStatus> statuses;             // vehicle.status
+    std::vector<uint8_t> loads;                      // vehicle.load
+    std::vector<uint8_t> capacities;                 // vehicle.capacity
+};
+
 //////////////////////////////////////////////////////////////////////////////////////////////////
 /// Dispatch Types
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -5,6 +5,8 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+
 #undef NDEBUG
 #include <assert.h>
 
@@ -47,56 +49,67 @@ void TruncateStepByTime(Step &step, uint64_t time_ms) {
            "Output step's duration in truncate_step_by_time() must be positive!");
 }
 
-void TruncateRouteByTime(Route &route, uint64_t time_ms) {
-    assert(route.steps.size() >= 2 &&
-           "Input route in truncate_route_by_time() must have at least 2 steps!");
-    assert(route.distance_mm > 0 &&
-           "Input route's distance in truncate_route_by_time() must be positive!");
-    assert(route.duration_ms > 0 &&
-           "Input route's duration in truncate_route_by_time() must be positive!");
-    assert(time_ms >= 0 && "Time in truncate_route_by_time() must be non negative!");
-    assert(time_ms < route.duration_ms && "Time in truncate_route_by_time() must be less than route's duration!");
+void AdvanceRouteCursorByTime(const Route &route, RouteCursor &cursor, uint64_t time_ms) {
+    assert(route.accumulated_duration_ms.size() == route.steps.size() &&
+           "Input route in advance_route_cursor_by_time() must be a full route!");
+    assert(cursor.elapsed_ms + time_ms < route.duration_ms &&
+           "Time in advance_route_cursor_by_time() must be less than route's remaining duration!");
+
+    cursor.elapsed_ms += time_ms;
+    // The vehicle is on the last step that starts no later than the elapsed time. (The steps that have zero duration
+    // at this time are skipped, as they are finished.)
+    auto iter = std::upper_bound(route.accumulated_duration_ms.begin() + cursor.step_idx,
+                                 route.accumulated_duration_ms.end(), cursor.elapsed_ms);
+    cursor.step_idx = iter - route.accumulated_duration_ms.begin() - 1;
+
+    assert(route.steps[cursor.step_idx].duration_ms > 0 &&
+           "Output cursor of advance_route_cursor_by_time() must be on a step with positive duration!");
+}
 
-    // Early return.
-    if (time_ms == 0) {
-        return;
-    }
+Pos GetPosAtRouteCursor(const Route &route, const RouteCursor &cursor) {
+    const auto &step = route.steps[cursor.step_idx];
+    const auto time_ms = cursor.elapsed_ms - route.accumulated_duration_ms[cursor.step_idx];
+    if (time_ms == 0) { return step.poses[0]; }
 
-    for (auto i = 0; i < route.steps.size(); i++) {
-        auto &step = route.steps[i];
+    auto ratio = static_cast<double>(time_ms) / step.duration_ms;
+    // When the vehicle is travelling on the link from point A (step.poses[0]) to point B (step.poses[1]),
+    // it can be treated as it were at point B to do route planning, considering the time left to arrive point B.
+    Pos pos;
+    pos.node_id = step.poses[1].node_id;
+    pos.lon = step.poses[0].lon + ratio * (step.poses[1].lon - step.poses[0].lon);
+    pos.lat = step.poses[0].lat + ratio * (step.poses[1].lat - step.poses[0].lat);
+    return pos;
+}
 
-        // If we can finish this step within the time, remove the entire step.
-        if (step.duration_ms <= time_ms) {
-            time_ms -= step.duration_ms;
-            continue;
-        }
-        // If we can not finish this step, truncate the step.
-        TruncateStepByTime(step, time_ms);
-        route.steps.erase(route.steps.begin(), route.steps.begin() + i);
+Step GetRemainingStepAtRouteCursor(const Route &route, const RouteCursor &cursor) {
+    const auto &step = route.steps[cursor.step_idx];
+    const auto time_ms = cursor.elapsed_ms - route.accumulated_duration_ms[cursor.step_idx];
+    if (time_ms == 0) { return step; }
 
-        break;
-    }
+    auto ratio = static_cast<double>(time_ms) / step.duration_ms;
+    Step remaining_step;
+    remaining_step.distance_mm = step.distance_mm * (1 - ratio);
+    remaining_step.duration_ms = step.duration_ms - time_ms;
+    remaining_step.poses.push_back(GetPosAtRouteCursor(route, cursor));
+    remaining_step.poses.push_back(step.poses[1]);
+    return remaining_step;
+}
 
-    // Recalculate the total duration and distance.
-    route.distance_mm = 0;
-    route.duration_ms = 0;
-    for (const auto &step : route.steps) {
-        route.distance_mm += step.distance_mm;
-        route.duration_ms += step.duration_ms;
-    }
+int32_t GetDistanceTraveledAtRouteCursor(const Route &route, const RouteCursor &cursor) {
+    const auto &step = route.steps[cursor.step_idx];
+    const auto time_ms = cursor.elapsed_ms - route.accumulated_duration_ms[cursor.step_idx];
+    if (time_ms == 0) { return route.accumulated_distance_mm[cursor.step_idx]; }
 
-    assert(route.steps.size() >= 2 &&
-           "Output route in truncate_route_by_time() must have at least 2 steps!");
-    // normally distance_mm should be larger than 0,
-    // but sometimes the distance_mm could be less than 1 and converted to 0, e.g. 370 * (1-4990/5000) = 0.74 = 0 (int)
-    assert(route.distance_mm >= 0 &&
-           "Output route's distance in truncate_route_by_time() must be positive!");
-    assert(route.duration_ms > 0 &&
-           "Output route's duration in truncate_route_by_time() must be positive!");
+    auto ratio = static_cast<double>(time_ms) / step.duration_ms;
+    // normally the remaining distance should be larger than 0,
+    // but sometimes it could be less than 1 and converted to 0, e.g. 370 * (1-4990/5000) = 0.74 = 0 (int)
+    return route.accumulated_distance_mm[cursor.step_idx] + step.distance_mm
+           - static_cast<int32_t>(step.distance_mm * (1 - ratio));
 }
 
 std::pair<std::vector<size_t>, std::vector<size_t>> UpdVehiclePos(Vehicle &vehicle,
-                                                                  std::vector<Order> &orders,
+                                                                  FleetState &fleet_state,
+                                                                  OrderStore &orders,
                                                                   uint64_t system_time_ms,
                                                                   uint64_t time_ms,
                                                                   bool update_vehicle_statistics) {
@@ -133,6 +146,7 @@ std::pair<std::vector<size_t>, std::vector<size_t>> UpdVehiclePos(Vehicle &vehic
                 vehicle.empty_time_traveled_ms += time_ms;
             }
         }
+        SyncFleetState(fleet_state, vehicle);
         return {new_picked_order_ids, new_dropped_order_ids};
     }
 
@@ -144,25 +158,31 @@ std::pair<std::vector<size_t>, std::vector<size_t>> UpdVehiclePos(Vehicle &vehic
     for (auto i = 0; i < vehicle.schedule.size(); i++) {
         auto &wp = vehicle.schedule[i];
 
+        // The route of the first waypoint may have been partially traveled, as indicated by the vehicle's cursor.
+        const auto remaining_duration_ms = wp.route.duration_ms - vehicle.route_cursor.elapsed_ms;
+        const auto remaining_distance_mm =
+                wp.route.distance_mm - GetDistanceTraveledAtRouteCursor(wp.route, vehicle.route_cursor);
+
         // If we can finish this waypoint within the time.
-        if (wp.route.duration_ms <= time_ms) {
-            system_time_ms += wp.route.duration_ms;
-            time_ms -= wp.route.duration_ms;
+        if (remaining_duration_ms <= time_ms) {
+            system_time_ms += remaining_duration_ms;
+            time_ms -= remaining_duration_ms;
+            vehicle.route_cursor = RouteCursor();
 
             vehicle.pos = wp.pos;
 
             if (update_vehicle_statistics) {
-                vehicle.dist_traveled_mm += wp.route.distance_mm;
-                vehicle.loaded_dist_traveled_mm += wp.route.distance_mm * vehicle.load;
-                vehicle.time_traveled_ms += wp.route.duration_ms;
-                vehicle.loaded_time_traveled_ms += wp.route.duration_ms * vehicle.load;
+                vehicle.dist_traveled_mm += remaining_distance_mm;
+                vehicle.loaded_dist_traveled_mm += remaining_distance_mm * vehicle.load;
+                vehicle.time_traveled_ms += remaining_duration_ms;
+                vehicle.loaded_time_traveled_ms += remaining_duration_ms * vehicle.load;
                 if (vehicle.status == VehicleStatus::WORKING && vehicle.load == 0) {
-                    vehicle.empty_dist_traveled_mm += wp.route.distance_mm;
-                    vehicle.empty_time_traveled_ms += wp.route.duration_ms;
+                    vehicle.empty_dist_traveled_mm += remaining_distance_mm;
+                    vehicle.empty_time_traveled_ms += remaining_duration_ms;
                 }
                 if (vehicle.status == VehicleStatus::REBALANCING) {
-                    vehicle.rebl_dist_traveled_mm += wp.route.distance_mm;
-                    vehicle.rebl_time_traveled_ms += wp.route.duration_ms;
+                    vehicle.rebl_dist_traveled_mm += remaining_distance_mm;
+                    vehicle.rebl_time_traveled_ms += remaining_duration_ms;
                 }
             }
 
@@ -205,16 +225,14 @@ std::pair<std::vector<size_t>, std::vector<size_t>> UpdVehiclePos(Vehicle &vehic
             continue;
         }
 
-        // If we can not finish this waypoint, truncate the route.
-        const auto original_distance_mm = wp.route.distance_mm;
-        const auto original_duration_ms = wp.route.duration_ms;
-
-        TruncateRouteByTime(wp.route, time_ms);
-        vehicle.pos = wp.route.steps.front().poses.front();
+        // If we can not finish this waypoint, move the cursor on the route.
+        AdvanceRouteCursorByTime(wp.route, vehicle.route_cursor, time_ms);
+        vehicle.pos = GetPosAtRouteCursor(wp.route, vehicle.route_cursor);
 
         if (update_vehicle_statistics) {
-            const auto dist_traveled_mm = original_distance_mm - wp.route.distance_mm;
-            const auto time_traveled_ms = original_duration_ms - wp.route.duration_ms;
+            const auto dist_traveled_mm = remaining_distance_mm - wp.route.distance_mm
+                                          + GetDistanceTraveledAtRouteCursor(wp.route, vehicle.route_cursor);
+            const auto time_traveled_ms = time_ms;
             vehicle.dist_traveled_mm += dist_traveled_mm;
             vehicle.loaded_dist_traveled_mm += dist_traveled_mm * vehicle.load;
             vehicle.time_traveled_ms += time_traveled_ms;
@@ -232,17 +250,39 @@ std::pair<std::vector<size_t>, std::vector<size_t>> UpdVehiclePos(Vehicle &vehic
         vehicle.schedule.erase(vehicle.schedule.begin(), vehicle.schedule.begin() + i);
 
         // If the vehicle is currently on a link, we store its unfinished step to step_to_pos.
-        auto first_step_of_route = vehicle.schedule[0].route.steps[0];
-        if (first_step_of_route.poses[0].node_id == first_step_of_route.poses[1].node_id) {
-            vehicle.step_to_pos = first_step_of_route;
-            assert (first_step_of_route.duration_ms != 0);
+        auto remaining_step = GetRemainingStepAtRouteCursor(vehicle.schedule[0].route, vehicle.route_cursor);
+        if (remaining_step.poses[0].node_id == remaining_step.poses[1].node_id) {
+            vehicle.step_to_pos = std::move(remaining_step);
+            assert (vehicle.step_to_pos.duration_ms != 0);
             assert (vehicle.pos.node_id == vehicle.step_to_pos.poses[0].node_id);
         }
+        SyncFleetState(fleet_state, vehicle);
         return {new_picked_order_ids, new_dropped_order_ids};
     }
 
     // We've finished the whole schedule.
     vehicle.schedule.clear();
     vehicle.status = VehicleStatus::IDLE;
+    SyncFleetState(fleet_state, vehicle);
     return {new_picked_order_ids, new_dropped_order_ids};
 }
+
+void InitFleetState(FleetState &fleet_state, const std::vector<Vehicle> &vehicles) {
+    fleet_state.node_ids.resize(vehicles.size());
+    fleet_state.step_to_pos_durations_ms.resize(vehicles.size());
+    fleet_state.statuses.resize(vehicles.size());
+    fleet_state.loads.resize(vehicles.size());
+    fleet_state.capacities.resize(vehicles.size());
+    for (const auto &vehicle : vehicles) {
+        assert(vehicle.id < vehicles.size() && vehicle.capacity <= UINT8_MAX);
+        fleet_state.capacities[vehicle.id] = vehicle.capacity;
+        SyncFleetState(fleet_state, vehicle);
+    }
+}
+
+void SyncFleetState(FleetState &fleet_state, const Vehicle &vehicle) {
+    fleet_state.node_ids[vehicle.id] = vehicle.pos.node_id;
+    fleet_state.step_to_pos_durations_ms[vehicle.id] = vehicle.step_to_pos.duration_ms;
+    fleet_state.statuses[vehicle.id] = vehicle.status;
+    fleet_state.loads[vehicle.id] = vehicle.load;
+}
@@ -3,6 +3,7 @@
 
 #pragma once
 #include "types.hpp"
+#include "order_store.hpp"
 
 #undef NDEBUG
 #include <assert.h>
@@ -10,17 +11,34 @@
 /// \brief Trucate Step so that the first x milliseconds worth of route is completed.
 void TruncateStepByTime(Step &step, uint64_t time_ms);
 
-/// \brief Trucate Route so that the first x milliseconds worth of route is completed.
-void TruncateRouteByTime(Route &route, uint64_t time_ms);
+/// \brief Move the cursor on the route forward by x milliseconds (binary search on the accumulated durations).
+void AdvanceRouteCursorByTime(const Route &route, RouteCursor &cursor, uint64_t time_ms);
+
+/// \brief Get the position at the cursor. In the middle of a step, it is interpolated and takes the step's end node.
+Pos GetPosAtRouteCursor(const Route &route, const RouteCursor &cursor);
+
+/// \brief Get the unfinished part of the step at the cursor.
+Step GetRemainingStepAtRouteCursor(const Route &route, const RouteCursor &cursor);
+
+/// \brief Get the distance traveled from the start of the route to the cursor.
+int32_t GetDistanceTraveledAtRouteCursor(const Route &route, const RouteCursor &cursor);
 
 /// \brief Update the vehicle position by x milliseconds .
 /// \param vehicle the vehicle that contains a schedule to be processed.
+/// \param fleet_state the fleet state, whose entry of the vehicle is synced after the update.
 /// \param orders the reference to the orders.
 /// \param system_time_ms the current system time in milliseconds.
 /// \param time_ms the time in seconds that we need to advance the system.
 /// \param update_vehicle_stats true if we update the vehicle statistics.
 std::pair<std::vector<size_t>, std::vector<size_t>> UpdVehiclePos(Vehicle &vehicle,
-                     std::vector<Order> &orders,
+                     FleetState &fleet_state,
+                     OrderStore &orders,
                      uint64_t system_time_ms,
                      uint64_t time_ms,
-                     bool update_vehicle_stats = true);
\ No newline at end of file
+                     bool update_vehicle_stats = true);
+
+/// \brief Build the fleet state (the structure-of-arrays mirror of the vehicles' hot fields) of the whole fleet.
+void InitFleetState(FleetState &fleet_state, const std::vector<Vehicle> &vehicles);
+
+/// \brief Copy the vehicle's hot fields to its entry in the fleet state.
+void SyncFleetState(FleetState &fleet_state, const Vehicle &vehicle);
@@ -0,0 +1,104 @@
+#include "profiler.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#undef NDEBUG
+#include <assert.h>
+
+const char *ToString(ProfilerPhase phase) {
+    switch (phase) {
+        case ProfilerPhase::ADVANCE: return "advance";
+        case ProfilerPhase::GENERATE: return "generate";
+        case ProfilerPhase::PAIR_GEN: return "pair_gen";
+        case ProfilerPhase::SCORING: return "scoring";
+        case ProfilerPhase::ILP: return "ilp";
+        case ProfilerPhase::ROUTE_BUILD: return "route_build";
+        case ProfilerPhase::REBALANCE: return "rebalance";
+        case ProfilerPhase::DATALOG: return "datalog";
+    }
+    return "unknown";
+}
+
+size_t PhaseHistogram::getBucketIdx(uint64_t duration_ns) {
+    if (duration_ns < num_of_sub_buckets_) { return duration_ns; }
+    int shift = 63 - __builtin_clzll(duration_ns) - sub_bucket_bits_;
+    return (shift + 1) * num_of_sub_buckets_ + ((duration_ns >> shift) & (num_of_sub_buckets_ - 1));
+}
+
+std::pair<uint64_t, uint64_t> PhaseHistogram::getBucketRange(size_t bucket_idx) {
+    if (bucket_idx < num_of_sub_buckets_) { return {bucket_idx, bucket_idx}; }
+    int shift = bucket_idx / num_of_sub_buckets_ - 1;
+    uint64_t lower = (num_of_sub_buckets_ + bucket_idx % num_of_sub_buckets_) << shift;
+    return {lower, lower + ((static_cast<uint64_t>(1) << shift) - 1)};
+}
+
+void PhaseHistogram::Record(uint64_t duration_ns) {
+    bucket_counts_[getBucketIdx(duration_ns)]++;
+    count_++;
+    total_ns_ += duration_ns;
+    min_ns_ = std::min(min_ns_, duration_ns);
+    max_ns_ = std::max(max_ns_, duration_ns);
+}
+
+uint64_t PhaseHistogram::getPercentileNs(double percentile) const {
+    assert(percentile >= 0 && percentile <= 100);
+    if (count_ == 0) { return 0; }
+
+    // The rank of the call at the percentile (1-based), and the bucket holding it. The middle of the bucket is
+    // returned, within the exact min and max.
+    auto rank = std::max(static_cast<uint64_t>(std::ceil(percentile / 100 * count_)), static_cast<uint64_t>(1));
+    uint64_t accumulated_count = 0;
+    for (auto i = 0; i < num_of_buckets_; i++) {
+        accumulated_count += bucket_counts_[i];
+        if (accumulated_count >= rank) {
+            auto [lower, upper] = getBucketRange(i);
+            return std::clamp(lower + (upper - lower) / 2, min_ns_, max_ns_);
+        }
+    }
+    return max_ns_;
+}
+
+Profiler &Profiler::Global() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::Reset() {
+    histograms_ = {};
+    ResetDispatchCounters();
+}
+
+void Profiler::ExportToFile(const std::string &path_to_output_profile, ProfileFormat format) const {
+    std::ofstream profile_file(path_to_output_profile);
+    assert(profile_file.is_open() && "[ERROR] Failed to open the output profile file!");
+
+    if (format == ProfileFormat::CSV) {
+        profile_file << "phase,calls,total_ms,min_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+    } else {
+        profile_file << "{\n  \"phases\": [";
+    }
+    for (auto i = 0; i < num_of_profiler_phases; i++) {
+        const auto &histogram = histograms_[i];
+        auto phase_name = ToString(static_cast<ProfilerPhase>(i));
+        if (format == ProfileFormat::CSV) {
+            profile_file << fmt::format("{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f}\n",
+                                        phase_name, histogram.getCount(), histogram.getTotalNs() / 1e6,
+                                        histogram.getMinNs() / 1e6, histogram.getPercentileNs(50) / 1e6,
+                                        histogram.getPercentileNs(95) / 1e6, histogram.getPercentileNs(99) / 1e6,
+                                        histogram.getMaxNs() / 1e6);
+        } else {
+            profile_file << fmt::format("{}\n    {{\"phase\": \"{}\", \"calls\": {}, \"total_ms\": {:.3f}, "
+                                        "\"min_ms\": {:.3f}, \"p50_ms\": {:.3f}, \"p95_ms\": {:.3f}, "
+                                        "\"p99_ms\": {:.3f}, \"max_ms\": {:.3f}}}",
+                                        i == 0 ? "" : ",", phase_name, histogram.getCount(),
+                                        histogram.getTotalNs() / 1e6, histogram.getMinNs() / 1e6,
+                                        histogram.getPercentileNs(50) / 1e6, histogram.getPercentileNs(95) / 1e6,
+                                        histogram.getPercentileNs(99) / 1e6, histogram.getMaxNs() / 1e6);
+        }
+    }
+    if (format == ProfileFormat::JSON) { profile_file << "\n  ]\n}\n"; }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// \brief The phases of an epoch timed by the profiler.
+enum class ProfilerPhase : uint8_t {
+    ADVANCE,      // advancing the vehicles (and bringing them to the system time in event-driven mode)
+    GENERATE,     // generating the new orders
+    PAIR_GEN,     // computing the feasible vehicle-trip pairs (GI: the insertion search of one order)
+    SCORING,      // scoring the vehicle-trip pairs
+    ILP,          // solving the assignment (ILP, or greedy)
+    ROUTE_BUILD,  // updating the assigned vehicles' schedules and building their routes
+    REBALANCE,    // repositioning the idle vehicles
+    DATALOG       // writing a frame to the datalog
+};
+
+/// \brief The number of the profiler phases.
+constexpr size_t num_of_profiler_phases = 8;
+
+/// \brief The name of the phase, as printed in the report and exported.
+const char *ToString(ProfilerPhase phase);
+
+/// \brief The format of the exported profile.
+enum class ProfileFormat {
+    CSV,   // one row per phase
+    JSON   // one object per phase
+};
+
+/// \brief The histogram of the durations of a phase, with a bounded memory no matter how many calls are recorded.
+/// \details The durations (in ns) below 16 have their own buckets. Above, each power of two is split into 16 linear
+/// buckets, so that a percentile is off by at most 1/16 (6.25%) of its value. The count, total, min and max are exact.
+class PhaseHistogram {
+  public:
+    /// \brief Record the duration of one call.
+    void Record(uint64_t duration_ns);
+
+    /// \brief Get the duration (in ns) at the given percentile (0 - 100), 0 if no call is recorded.
+    uint64_t getPercentileNs(double percentile) const;
+
+    uint64_t getCount() const { return count_; }
+    uint64_t getTotalNs() const { return total_ns_; }
+    uint64_t getMinNs() const { return count_ > 0 ? min_ns_ : 0; }
+    uint64_t getMaxNs() const { return max_ns_; }
+
+  private:
+    /// \brief The number of linear buckets per power of two (as a power of two).
+    static constexpr int sub_bucket_bits_ = 4;
+    static constexpr uint64_t num_of_sub_buckets_ = 1 << sub_bucket_bits_;
+
+    /// \brief The buckets cover all uint64_t durations.
+    static constexpr size_t num_of_buckets_ = (64 - sub_bucket_bits_ + 1) * num_of_sub_buckets_;
+
+    /// \brief The bucket of the duration, and the range of durations [lower, upper] of a bucket.
+    static size_t getBucketIdx(uint64_t duration_ns);
+    static std::pair<uint64_t, uint64_t> getBucketRange(size_t bucket_idx);
+
+    std::array<uint64_t, num_of_buckets_> bucket_counts_ = {};
+    uint64_t count_ = 0;
+    uint64_t total_ns_ = 0;
+    uint64_t min_ns_ = UINT64_MAX;
+    uint64_t max_ns_ = 0;
+};
+
+/// \brief The size of the dispatch problem at one epoch, reported by the dispatcher for the per-epoch metrics.
+struct DispatchCounters {
+    size_t num_of_considered_orders = 0;               // the orders the dispatcher tries to assign
+    std::vector<size_t> num_of_vt_pairs_of_trip_size;  // [k] = the number of feasible vehicle-trip pairs of k orders
+    size_t num_of_ilp_variables = 0;                   // summed over the components solved by ILP
+    size_t num_of_ilp_constraints = 0;
+
+    /// \brief Add vehicle-trip pairs of the trip size.
+    void AddVtPairs(size_t trip_size, size_t num_of_pairs = 1) {
+        if (num_of_vt_pairs_of_trip_size.size() <= trip_size) { num_of_vt_pairs_of_trip_size.resize(trip_size + 1); }
+        num_of_vt_pairs_of_trip_size[trip_size] += num_of_pairs;
+    }
+};
+
+/// \brief The registry of the per-phase histograms, fed by the ScopedPhaseTimers in the platform, the dispatchers and
+/// the rebalancers, and of the dispatch counters of the current epoch. It is only recorded to from the simulation
+/// thread (not from the vehicle advancing threads).
+class Profiler {
+  public:
+    /// \brief The profiler of the simulation.
+    static Profiler &Global();
+
+    /// \brief Record the duration of one call of the phase.
+    void Record(ProfilerPhase phase, uint64_t duration_ns) {
+        histograms_[static_cast<size_t>(phase)].Record(duration_ns);
+    }
+
+    /// \brief Get the histogram of the phase.
+    const PhaseHistogram &getHistogram(ProfilerPhase phase) const { return histograms_[static_cast<size_t>(phase)]; }
+
+    /// \brief Get the dispatch counters of the current epoch.
+    DispatchCounters &getDispatchCounters() { return dispatch_counters_; }
+
+    /// \brief Clear the dispatch counters, at the start of each epoch.
+    void ResetDispatchCounters() { dispatch_counters_ = DispatchCounters(); }
+
+    /// \brief Clear all histograms and the dispatch counters.
+    void Reset();
+
+    /// \brief Export the count, total, min, p50/p95/p99 and max (in ms) of each phase to file.
+    void ExportToFile(const std::string &path_to_output_profile, ProfileFormat format) const;
+
+  private:
+    std::array<PhaseHistogram, num_of_profiler_phases> histograms_;
+    DispatchCounters dispatch_counters_;
+};
+
+/// \brief The timer that records the time from its construction to its destruction to the phase, with a monotonic
+/// nanosecond clock.
+class ScopedPhaseTimer {
+  public:
+    /// \brief Constructor. Start the timer.
+    explicit ScopedPhaseTimer(ProfilerPhase _phase) : phase_(_phase), start_time_(std::chrono::steady_clock::now()) {}
+
+    /// \brief Destructor. Record the elapsed time.
+    ~ScopedPhaseTimer() { Profiler::Global().Record(phase_, getElapsedNs()); }
+
+    /// \brief Delete the other constructors. Rule of five.
+    ScopedPhaseTimer(const ScopedPhaseTimer &other) = delete;
+    ScopedPhaseTimer(ScopedPhaseTimer &&other) = delete;
+    ScopedPhaseTimer &operator=(const ScopedPhaseTimer &other) = delete;
+    ScopedPhaseTimer &operator=(ScopedPhaseTimer &&other) = delete;
+
+    /// \brief Get the time elapsed since the timer started.
+    uint64_t getElapsedNs() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time_)
+                .count();
+    }
+
+  private:
+    ProfilerPhase phase_;
+    std::chrono::steady_clock::time_point start_time_;
+};
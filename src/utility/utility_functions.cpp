@@ -4,34 +4,97 @@
 #include "utility_functions.hpp"
 #include <iomanip>
 
-int32_t ConvertTimeDateToSeconds(std::string time_date) {
-    tm tm_time1;
-    time_t time_sec1;
-    tm_time1.tm_isdst = -1;
-    const char *time_date1 = time_date.c_str();
-    strptime(time_date1, "%Y-%m-%d %H:%M:%S", &tm_time1);
-    time_sec1 = mktime(&tm_time1);
-    int32_t converted_time_sec = time_sec1;
-    return converted_time_sec;
+#undef NDEBUG
+#include <assert.h>
+
+namespace {
+/// \brief The number of days from 1970-01-01 to the civil date (proleptic Gregorian calendar).
+int32_t DaysFromCivil(int32_t year, int32_t month, int32_t day) {
+    year -= month <= 2;
+    const int32_t era = (year >= 0 ? year : year - 399) / 400;
+    const int32_t year_of_era = year - era * 400;
+    const int32_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const int32_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+/// \brief The inverse of DaysFromCivil.
+void CivilFromDays(int32_t days, int32_t &year, int32_t &month, int32_t &day) {
+    days += 719468;
+    const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int32_t day_of_era = days - era * 146097;
+    const int32_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    const int32_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    const int32_t shifted_month = (5 * day_of_year + 2) / 153;
+    day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    year = year_of_era + era * 400 + (month <= 2);
+}
+
+/// \brief The value of the digits in [first, first + num_of_digits).
+inline int32_t ParseDigits(const char *first, size_t num_of_digits) {
+    int32_t value = 0;
+    for (auto i = 0; i < num_of_digits; i++) { value = value * 10 + (first[i] - '0'); }
+    return value;
+}
+}
+
+bool IsValidTimeDate(const char *time_date, size_t length) {
+    // "YYYY-MM-DD HH:MM:SS"
+    if (length != 19) { return false; }
+    for (auto i = 0; i < 19; i++) {
+        if (i == 4 || i == 7) {
+            if (time_date[i] != '-') { return false; }
+        } else if (i == 10) {
+            if (time_date[i] != ' ') { return false; }
+        } else if (i == 13 || i == 16) {
+            if (time_date[i] != ':') { return false; }
+        } else if (time_date[i] < '0' || time_date[i] > '9') {
+            return false;
+        }
+    }
+    auto month = ParseDigits(time_date + 5, 2);
+    auto day = ParseDigits(time_date + 8, 2);
+    return month >= 1 && month <= 12 && day >= 1 && day <= 31 && ParseDigits(time_date + 11, 2) < 24 &&
+           ParseDigits(time_date + 14, 2) < 60 && ParseDigits(time_date + 17, 2) < 60;
+}
+
+bool IsValidTimeDate(const std::string &time_date) {
+    return IsValidTimeDate(time_date.data(), time_date.size());
+}
+
+int32_t ConvertTimeDateToSeconds(const char *time_date, size_t length) {
+    assert(IsValidTimeDate(time_date, length) && "[ERROR] The time date is not in \"%Y-%m-%d %H:%M:%S\"!");
+    auto days = DaysFromCivil(ParseDigits(time_date, 4), ParseDigits(time_date + 5, 2), ParseDigits(time_date + 8, 2));
+    return days * 86400 + ParseDigits(time_date + 11, 2) * 3600 + ParseDigits(time_date + 14, 2) * 60 +
+           ParseDigits(time_date + 17, 2);
+}
+
+int32_t ConvertTimeDateToSeconds(const std::string &time_date) {
+    return ConvertTimeDateToSeconds(time_date.data(), time_date.size());
 }
 
 std::string ConvertTimeSecondToDate(int32_t time_sec) {
-    int32_t time_test = time_sec;
-    time_t time_sec2;
-    tm tm_time2;
-    tm_time2.tm_isdst = -1;
-    char time_date2[128]= {0};
-    time_sec2 = time_test;
-    tm_time2 = *localtime(&time_sec2);
-    strftime(time_date2, 64, "%Y-%m-%d %H:%M:%S", &tm_time2);
-    std::string converted_time_date = time_date2;
-    return converted_time_date;
+    auto days = time_sec >= 0 ? time_sec / 86400 : (time_sec - 86399) / 86400;
+    auto sec_of_day = time_sec - days * 86400;
+    int32_t year, month, day;
+    CivilFromDays(days, year, month, day);
+    return fmt::format("{:04d}-{:02d}-{:02d} {:02d}:{:02d}:{:02d}",
+                       year, month, day, sec_of_day / 3600, sec_of_day / 60 % 60, sec_of_day % 60);
 }
 
-int32_t ComputeTheAccumulatedSecondsFrom0Clock(std::string time_date) {
-  std::string time_0_clock = time_date.substr(0,10) + " 00:00:00";
-  int32_t accumulated_sec = ConvertTimeDateToSeconds(time_date) - ConvertTimeDateToSeconds(time_0_clock);
-  return accumulated_sec;
+std::string ConvertTimeStampToLocalDate(std::time_t time_stamp_s) {
+    tm tm_time;
+    char time_date[64] = {0};
+    localtime_r(&time_stamp_s, &tm_time);
+    strftime(time_date, sizeof(time_date), "%Y-%m-%d %H:%M:%S", &tm_time);
+    return time_date;
+}
+
+int32_t ComputeTheAccumulatedSecondsFrom0Clock(const std::string &time_date) {
+    assert(IsValidTimeDate(time_date) && "[ERROR] The time date is not in \"%Y-%m-%d %H:%M:%S\"!");
+    return ParseDigits(time_date.data() + 11, 2) * 3600 + ParseDigits(time_date.data() + 14, 2) * 60 +
+           ParseDigits(time_date.data() + 17, 2);
 }
 
 std::time_t getTimeStampMs() {
@@ -41,6 +104,15 @@ std::time_t getTimeStampMs() {
     return timestamp_ms;
 }
 
+bool CpuSupportsAvx2() {
+#ifdef AMOD_X86_SIMD
+    static const bool cpu_supports_avx2 = __builtin_cpu_supports("avx2");
+    return cpu_supports_avx2;
+#else
+    return false;
+#endif
+}
+
 void CheckFileExistence(const std::string& path_to_file) {
     struct stat buffer;
     if (stat(path_to_file.c_str(), &buffer) != 0){
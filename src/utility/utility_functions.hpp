@@ -5,6 +5,7 @@
 #pragma once
 
 #include "simulator/types.hpp"
+#include "utility/profiler.hpp"
 
 #include <sys/stat.h>
 
@@ -15,21 +16,51 @@
 #include <ctime>
 #include <chrono>
 
-/// \brief A function converting "%Y-%m-%d %H:%M:%S" to seconds.
-int32_t ConvertTimeDateToSeconds(std::string time_date);
+/// \brief A function checking whether the string is a valid time date in "%Y-%m-%d %H:%M:%S".
+bool IsValidTimeDate(const char *time_date, size_t length);
+bool IsValidTimeDate(const std::string &time_date);
 
-/// \brief A function converting seconds to "%Y-%m-%d %H:%M:%S".
+/// \brief A function converting "%Y-%m-%d %H:%M:%S" to seconds (from 1970-01-01 00:00:00).
+/// \details The fixed format is parsed arithmetically, without any locale or time zone lookup.
+int32_t ConvertTimeDateToSeconds(const char *time_date, size_t length);
+int32_t ConvertTimeDateToSeconds(const std::string &time_date);
+
+/// \brief A function converting seconds (from 1970-01-01 00:00:00) to "%Y-%m-%d %H:%M:%S", the inverse of
+/// ConvertTimeDateToSeconds.
 std::string ConvertTimeSecondToDate(int32_t time_sec);
 
+/// \brief A function converting a real world time stamp (in seconds) to "%Y-%m-%d %H:%M:%S" in local time.
+std::string ConvertTimeStampToLocalDate(std::time_t time_stamp_s);
+
 /// \brief A function computing the accumulated seconds of the day from "%Y-%m-%d %H:%M:%S",
 /// e.g. "2015-05-25 01:00:00" -> 3600
-int32_t ComputeTheAccumulatedSecondsFrom0Clock(std::string time_date);
+int32_t ComputeTheAccumulatedSecondsFrom0Clock(const std::string &time_date);
 
 /// \brief The current time of the system, used to calculate the computational time
 std::time_t getTimeStampMs();
 
+/// \brief The seconds (in ms resolution) elapsed since the time stamp of TIMER_START, or since the phase timer started.
+inline double getElapsedSeconds(std::time_t start_time_stamp_ms) {
+    return (getTimeStampMs() - start_time_stamp_ms) / 1000.0;
+}
+inline double getElapsedSeconds(const ScopedPhaseTimer &phase_timer) {
+    return phase_timer.getElapsedNs() / 1000000 / 1000.0;
+}
+
+/// \brief TIMER_END prints the time elapsed since TIMER_START (debug print only). The phases of an epoch are timed by
+/// a ScopedPhaseTimer instead, which records them to the profiler and can be printed by TIMER_END as well.
 #define TIMER_START(start_time) auto start_time = getTimeStampMs();
-#define TIMER_END(start_time) std::cout << "  (" << (getTimeStampMs() - start_time) / 1000.0 << "s)\n";
+#define TIMER_END(start_time) std::cout << "  (" << getElapsedSeconds(start_time) << "s)\n";
+
+/// \brief AMOD_X86_SIMD is defined if the x86 SIMD kernels can be compiled (GCC/Clang on x86). Their AVX2 versions are
+/// built with AMOD_TARGET_AVX2 (no global -mavx2 flag is needed) and only called if CpuSupportsAvx2() at run time.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define AMOD_X86_SIMD
+#define AMOD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/// \brief Return true if the CPU supports AVX2.
+bool CpuSupportsAvx2();
 
 /// \brief A function to check whether the data file exists.
 void CheckFileExistence(const std::string &path_to_file);
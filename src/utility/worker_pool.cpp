@@ -0,0 +1,56 @@
+#include "worker_pool.hpp"
+
+#undef NDEBUG
+#include <assert.h>
+
+WorkerPool::WorkerPool(size_t _num_of_workers) {
+    for (auto k = 1; k < _num_of_workers; k++) { threads_.emplace_back(&WorkerPool::RunWorkerThread, this, k); }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        workers_should_stop_ = true;
+    }
+    task_given_cv_.notify_all();
+    for (auto &thread : threads_) { thread.join(); }
+}
+
+void WorkerPool::Run(const std::function<void(size_t)> &task) {
+    if (threads_.empty()) {
+        task(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        assert(num_of_running_workers_ == 0 && "WorkerPool::Run() must not be called concurrently!");
+        task_ = &task;
+        task_generation_++;
+        num_of_running_workers_ = threads_.size();
+    }
+    task_given_cv_.notify_all();
+    task(0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_finished_cv_.wait(lock, [this] { return num_of_running_workers_ == 0; });
+    task_ = nullptr;
+}
+
+void WorkerPool::RunWorkerThread(size_t k) {
+    uint64_t last_task_generation = 0;
+    while (true) {
+        const std::function<void(size_t)> *task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_given_cv_.wait(lock, [&] { return workers_should_stop_ || task_generation_ != last_task_generation; });
+            if (workers_should_stop_) { return; }
+            last_task_generation = task_generation_;
+            task = task_;
+        }
+        (*task)(k);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            num_of_running_workers_--;
+        }
+        task_finished_cv_.notify_one();
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// \brief The pool of persistent worker threads that run a task in parallel, one call per worker.
+/// \details The threads are created once and wait for tasks, so that running a task only costs a wake-up instead of
+/// creating and joining threads. Worker 0 is the calling thread, so a pool of one worker runs the task serially.
+class WorkerPool {
+  public:
+    /// \brief Constructor. Start _num_of_workers - 1 threads.
+    explicit WorkerPool(size_t _num_of_workers = 1);
+
+    /// \brief Destructor. Stop and join the threads.
+    ~WorkerPool();
+
+    /// \brief Delete the other constructors. Rule of five.
+    WorkerPool(const WorkerPool &other) = delete;
+    WorkerPool(WorkerPool &&other) = delete;
+    WorkerPool &operator=(const WorkerPool &other) = delete;
+    WorkerPool &operator=(WorkerPool &&other) = delete;
+
+    /// \brief Get the number of workers, including the calling thread.
+    size_t getNumOfWorkers() const { return threads_.size() + 1; }
+
+    /// \brief Run task(k) on each worker k in [0, num_of_workers) and wait until all of them return.
+    void Run(const std::function<void(size_t)> &task);
+
+  private:
+    /// \brief The loop of worker k (k >= 1).
+    void RunWorkerThread(size_t k);
+
+    /// \brief The threads of workers 1, 2, ...
+    std::vector<std::thread> threads_;
+
+    /// \brief The task being run, valid while num_of_running_workers_ > 0.
+    const std::function<void(size_t)> *task_ = nullptr;
+
+    /// \brief Increased at each task, so that a worker runs each task once.
+    uint64_t task_generation_ = 0;
+
+    /// \brief The number of threads that have not finished the current task.
+    size_t num_of_running_workers_ = 0;
+
+    /// \brief True if the threads should exit.
+    bool workers_should_stop_ = false;
+
+    /// \brief The mutex guarding the members above (except threads_).
+    std::mutex mutex_;
+
+    /// \brief Notified when a task is given (to the threads) or all threads have finished it (to the caller).
+    std::condition_variable task_given_cv_;
+    std::condition_variable task_finished_cv_;
+};